@@ -81,6 +81,9 @@ start:
     mov sp, 0x7C00
     sti                         
 
+    ; -- Collect the physical memory map while the BIOS is still reachable.
+    call detect_memory_e820
+
     ; -- Entering Protected mode: https://wiki.osdev.org/Protected_Mode
     ; 1. Disable interrupts.
     ; 2. Enable A20 Line.
@@ -108,6 +111,11 @@ start:
 %include "./asm-utils/print_string_rm.asm"
 %include "./boot/enable_A20_line.asm"
 %include "./boot/ATA_read_sector.asm"
+%include "./boot/detect_memory_e820.asm"
+
+%ifndef KERNEL_SECTORS
+%define KERNEL_SECTORS 199  ; Sectors 1-199, the FAT starts after the 200 reserved sectors.
+%endif
 
 [BITS 32]           ; We need to use the [bits 32] directive to tell our the assembler that,
                     ; from that point onwards, it should encode in 32-bit mode instructions.
@@ -115,8 +123,9 @@ start_protected_mode:
     mov eax, 0x01           ; @param EAX - Logical Block Address of sector.
                             ; We will read from sector 1,
                             ; because sector 0 is boot sector.
-    mov ecx, 0x64           ; @param ECX - Number of sectors to read.
-                            ; Read 100 sectors (1-100).
+    mov ecx, KERNEL_SECTORS ; @param ECX - Number of sectors to read.
+                            ; Read the whole reserved area after the boot sector (1-199),
+                            ; the kernel Makefile refuses kernels that do not fit.
     mov edi, 0x0100000      ; @param EDI - The address of buffer to put data obtained from disk.
                             ; Load them into address 0x0100000 (kernel code).
     call ATA_read_sector    ; Read sectors in LBA mode.
@@ -0,0 +1,53 @@
+; Detect the physical memory map with BIOS INT 15h, EAX = 0xE820.
+; The BIOS only answers in real mode, so the map is collected here and
+; left in conventional memory for the kernel's page frame allocator:
+;
+; E820_MAP_COUNT_ADDRESS    - dword, number of entries in the map.
+; E820_MAP_ENTRIES_ADDRESS  - array of 24-byte entries:
+;                             base (qword), length (qword), type (dword),
+;                             ACPI 3.0 extended attributes (dword).
+;
+; If the BIOS does not support the call, the count stays 0.
+; Reference: https://wiki.osdev.org/Detecting_Memory_(x86)#BIOS_Function:_INT_0x15.2C_EAX_.3D_0xE820
+
+E820_MAP_COUNT_ADDRESS      equ 0x0500
+E820_MAP_ENTRIES_ADDRESS    equ 0x0504
+E820_MAX_ENTRIES            equ 128
+E820_ENTRY_SIZE             equ 24
+E820_SMAP_SIGNATURE         equ 0x534D4150  ; 'SMAP'
+
+[BITS 16]
+detect_memory_e820:
+    mov dword [E820_MAP_COUNT_ADDRESS], 0
+    mov di, E820_MAP_ENTRIES_ADDRESS    ; ES:DI - buffer for the next entry.
+    xor ebx, ebx                        ; Continuation value, 0 to start.
+    xor bp, bp                          ; Number of entries stored.
+
+.next_entry:
+    mov eax, 0xE820
+    mov ecx, E820_ENTRY_SIZE
+    mov edx, E820_SMAP_SIGNATURE
+    mov dword [es:di + 20], 1           ; Mark the ACPI attributes valid,
+                                        ; in case the BIOS only fills 20 bytes.
+    int 0x15
+    jc .done                            ; Carry: unsupported, or past the last entry.
+    cmp eax, E820_SMAP_SIGNATURE
+    jne .done
+
+    jcxz .skip_entry                    ; Skip entries the BIOS left empty,
+    mov ecx, [es:di + 8]                ; and entries of zero length.
+    or ecx, [es:di + 12]
+    jz .skip_entry
+
+    inc bp
+    add di, E820_ENTRY_SIZE
+    cmp bp, E820_MAX_ENTRIES
+    je .done
+
+.skip_entry:
+    test ebx, ebx                       ; EBX = 0 after the last entry.
+    jnz .next_entry
+
+.done:
+    mov [E820_MAP_COUNT_ADDRESS], bp
+    ret
@@ -0,0 +1,210 @@
+#include <disk/cache.h>
+#include <memory/kheap.h>
+#include <string.h>
+#include <errno.h>
+#include <video.h>
+
+struct disk_cache
+{
+    struct disk_cache_block *blocks;
+    struct disk_cache_block *buckets[DISK_CACHE_TOTAL_BUCKETS];
+    struct disk_cache_block *newest;
+    struct disk_cache_block *oldest;
+    struct disk_cache_stats stats;
+};
+
+static struct disk_cache cache;
+
+static uint32_t disk_cache_hash(struct disk *disk, int lba)
+{
+    return ((uint32_t)lba + (disk->id * 31)) % DISK_CACHE_TOTAL_BUCKETS;
+}
+
+static void disk_cache_unlink_lru(struct disk_cache_block *block)
+{
+    if (block->newer != NULL)
+    {
+        block->newer->older = block->older;
+    }
+    else
+    {
+        cache.newest = block->older;
+    }
+
+    if (block->older != NULL)
+    {
+        block->older->newer = block->newer;
+    }
+    else
+    {
+        cache.oldest = block->newer;
+    }
+}
+
+static void disk_cache_push_lru(struct disk_cache_block *block)
+{ // Make the block the most recently used one.
+    block->newer = NULL;
+    block->older = cache.newest;
+    if (cache.newest != NULL)
+    {
+        cache.newest->newer = block;
+    }
+
+    cache.newest = block;
+    if (cache.oldest == NULL)
+    {
+        cache.oldest = block;
+    }
+}
+
+static void disk_cache_unlink_bucket(struct disk_cache_block *block)
+{
+    struct disk_cache_block **link = &cache.buckets[disk_cache_hash(block->disk, block->lba)];
+    while (*link != NULL && *link != block)
+    {
+        link = &(*link)->next;
+    }
+
+    if (*link != NULL)
+    {
+        *link = block->next;
+    }
+}
+
+static struct disk_cache_block *disk_cache_find(struct disk *disk, int lba)
+{
+    struct disk_cache_block *block = cache.buckets[disk_cache_hash(disk, lba)];
+    while (block != NULL && (block->disk != disk || block->lba != lba))
+    {
+        block = block->next;
+    }
+
+    return block;
+}
+
+static void disk_cache_insert(struct disk *disk, int lba, const void *data)
+{ // Reuse the least recently used block for the sector.
+    struct disk_cache_block *block = cache.oldest;
+    if (block->disk != NULL)
+    {
+        disk_cache_unlink_bucket(block);
+        cache.stats.evictions++;
+    }
+
+    block->disk = disk;
+    block->lba = lba;
+    memcpy(block->data, data, DISK_SECTOR_SIZE);
+
+    uint32_t bucket = disk_cache_hash(disk, lba);
+    block->next = cache.buckets[bucket];
+    cache.buckets[bucket] = block;
+
+    disk_cache_unlink_lru(block);
+    disk_cache_push_lru(block);
+}
+
+void disk_cache_init()
+{
+    memset(&cache, 0, sizeof(cache));
+    cache.blocks = kzalloc(DISK_CACHE_TOTAL_BLOCKS * sizeof(struct disk_cache_block));
+    if (cache.blocks == NULL)
+    { // Reads still work, they just all go to the disk.
+        print("Failed to allocate the disk cache.\n");
+        return;
+    }
+
+    for (int i = 0; i < DISK_CACHE_TOTAL_BLOCKS; i++)
+    {
+        disk_cache_push_lru(&cache.blocks[i]);
+    }
+}
+
+static int disk_cache_read_run(struct disk *disk, int lba, int sectors, char *buf)
+{ // Sectors missing from the cache, read with a single command.
+    int res = disk_read_blocks(disk, lba, sectors, buf);
+    if (res < 0)
+    {
+        return res;
+    }
+
+    cache.stats.misses += sectors;
+    if (cache.blocks == NULL || sectors > DISK_CACHE_MAX_CACHED_RUN)
+    {
+        return 0;
+    }
+
+    for (int i = 0; i < sectors; i++)
+    {
+        disk_cache_insert(disk, lba + i, buf + (i * DISK_SECTOR_SIZE));
+    }
+
+    return 0;
+}
+
+int disk_cache_read(struct disk *disk, int lba, int sectors, void *buf)
+{
+    int res = 0;
+    char *out = buf;
+    int run_start = 0;
+    int run_length = 0;
+    for (int i = 0; i < sectors; i++)
+    {
+        struct disk_cache_block *block = (cache.blocks != NULL) ? disk_cache_find(disk, lba + i) : NULL;
+        if (block == NULL)
+        {
+            run_start = (run_length == 0) ? i : run_start;
+            run_length++;
+            continue;
+        }
+
+        // Copy the hit before the run is cached, that may reuse the block.
+        memcpy(out + (i * DISK_SECTOR_SIZE), block->data, DISK_SECTOR_SIZE);
+        disk_cache_unlink_lru(block);
+        disk_cache_push_lru(block);
+        cache.stats.hits++;
+
+        if (run_length > 0)
+        {
+            res = disk_cache_read_run(disk, lba + run_start, run_length, out + (run_start * DISK_SECTOR_SIZE));
+            if (res < 0)
+            {
+                goto out;
+            }
+
+            run_length = 0;
+        }
+    }
+
+    if (run_length > 0)
+    {
+        res = disk_cache_read_run(disk, lba + run_start, run_length, out + (run_start * DISK_SECTOR_SIZE));
+    }
+
+out:
+    return res;
+}
+
+int disk_cache_write(struct disk *disk, int lba, int sectors, const void *buf)
+{ // Write through, cached copies of the sectors are kept up to date.
+    int res = disk_write_blocks(disk, lba, sectors, buf);
+    if (res < 0 || cache.blocks == NULL)
+    {
+        return res;
+    }
+
+    for (int i = 0; i < sectors; i++)
+    {
+        struct disk_cache_block *block = disk_cache_find(disk, lba + i);
+        if (block != NULL)
+        {
+            memcpy(block->data, buf + (i * DISK_SECTOR_SIZE), DISK_SECTOR_SIZE);
+        }
+    }
+
+    return 0;
+}
+
+void disk_cache_get_stats(struct disk_cache_stats *stats)
+{
+    memcpy(stats, &cache.stats, sizeof(struct disk_cache_stats));
+}
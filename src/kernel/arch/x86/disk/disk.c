@@ -1,4 +1,7 @@
 #include <disk/disk.h>
+#include <disk/cache.h>
+#include <disk/ide_dma.h>
+#include <task/wait_queue.h>
 #include <types.h>
 #include <io.h>
 #include <string.h>
@@ -8,8 +11,104 @@
 
 struct disk disk;
 
+struct disk_interrupt
+{
+    bool enabled;              // Polled until the interrupt has a handler.
+    struct wait_queue waiters; // Tasks sleeping until the drive interrupts.
+};
+
+static struct disk_interrupt disk_irq;
+
+void disk_interrupt_handler()
+{ // Reading the status acknowledges the interrupt of the drive.
+    inb(0x1F7);
+    wait_queue_wake_all(&disk_irq.waiters);
+    outb(0xA0, 0x20); // End of interrupt, for the slave PIC and the master.
+    outb(0x20, 0x20);
+}
+
+void disk_enable_interrupts()
+{
+    outb(0x3F6, 0x00); // Device control, clear nIEN so the drive raises IRQ 14.
+    disk_irq.enabled = true;
+}
+
+int disk_wait_for_interrupt()
+{
+    if (!disk_irq.enabled)
+    {
+        return -ENODEV;
+    }
+
+    return wait_queue_wait(&disk_irq.waiters, DISK_MAX_WAIT_INTERRUPTS);
+}
+
+static int disk_wait(bool interrupt, bool need_data)
+{ // Wait for the drive to finish a step of the command. With interrupts
+  // the task sleeps until the drive raises one, the status register is
+  // checked either way, with a bound on how long it is polled.
+    int res = 0;
+    if (interrupt && disk_irq.enabled)
+    {
+        res = disk_wait_for_interrupt();
+        if (res < 0)
+        {
+            goto out;
+        }
+    }
+
+    // The status is only valid 400ns after a command, four reads of the
+    // alternate status take that long.
+    for (int i = 0; i < 4; i++)
+    {
+        inb(0x3F6);
+    }
+
+    uint8_t status = inb(0x1F7);
+    int polls = 0;
+    while (polls < DISK_MAX_STATUS_POLLS &&
+           ((status & DISK_STATUS_BSY) ||
+            (need_data && !(status & (DISK_STATUS_DRQ | DISK_STATUS_ERR | DISK_STATUS_DF)))))
+    {
+        status = inb(0x1F7);
+        polls++;
+    }
+
+    if (polls == DISK_MAX_STATUS_POLLS)
+    {
+        res = -ETIMEDOUT;
+    }
+    else if (status & (DISK_STATUS_ERR | DISK_STATUS_DF))
+    {
+        res = -EIO;
+    }
+
+out:
+    return res;
+}
+
+int disk_wait_until_ready()
+{
+    return disk_wait(false, false);
+}
+
+int disk_reset()
+{ // SRST has to be held for at least 5us, the reads of the alternate
+  // status are the delay. nIEN stays as it was.
+    uint8_t control = disk_irq.enabled ? 0x00 : 0x02;
+    outb(0x3F6, control | 0x04);
+    for (int i = 0; i < 64; i++)
+    {
+        inb(0x3F6);
+    }
+
+    outb(0x3F6, control);
+    return disk_wait_until_ready();
+}
+
 int disk_read_sectors(int lba, int sectors, void *buf)
 {
+    int res = 0;
     outb(0x1F6, (lba >> 24) | 0b11100000);    // Port to send drive and bit 24 - 27 of LBA.
     outb(0x1F2, sectors);                     // Port to send number of sectors.
     outb(0x1F3, (uint8_t)(lba & 0b11111111)); // Port to send bit 0 - 7 of LBA.
@@ -19,27 +118,61 @@ int disk_read_sectors(int lba, int sectors, void *buf)
                                               // 0x20 - READ SECTORS(S)
                                               // 0x30 - WRITE SECTORS(S)
 
-    // We are going to read two bytes at a time from the disk controller.
-    uint16_t *ptr = (uint16_t *)buf;
+    char *ptr = buf;
 
     for (int s = 0; s < sectors; s++)
     {
-        // The sector buffer requires servicing until the sector buffer is ready.
-        int8_t byte = inb(0x1F7);
-        while (!(byte & 0x08))
+        // The drive interrupts once the sector buffer is ready.
+        res = disk_wait(true, true);
+        if (res < 0)
         {
-            byte = inb(0x1F7);
+            break;
         }
 
-        // Copy from hard disk to memory, to read 256 words = 1 sector.
-        for (int i = 0; i < 256; i++)
+        // Copy from hard disk to memory, 256 words = 1 sector, from the data port.
+        insw(0x1F0, ptr, DISK_SECTOR_SIZE / sizeof(uint16_t));
+        ptr += DISK_SECTOR_SIZE;
+    }
+
+    return res;
+}
+
+int disk_write_sectors(int lba, int sectors, const void *buf)
+{
+    int res = 0;
+    outb(0x1F6, (lba >> 24) | 0b11100000);    // Port to send drive and bit 24 - 27 of LBA.
+    outb(0x1F2, sectors);                     // Port to send number of sectors.
+    outb(0x1F3, (uint8_t)(lba & 0b11111111)); // Port to send bit 0 - 7 of LBA.
+    outb(0x1F4, (uint8_t)(lba >> 8));         // Port to send bit 8 - 15 of LBA.
+    outb(0x1F5, (uint8_t)(lba >> 16));        // Port to send bit 16 - 23 of LBA.
+    outb(0x1F7, 0x30);                        // Command port, 0x30 - WRITE SECTORS(S).
+
+    const char *ptr = buf;
+    for (int s = 0; s < sectors; s++)
+    {
+        // The drive asks for the first sector without an interrupt, it
+        // interrupts after taking each of the others.
+        res = disk_wait(s > 0, true);
+        if (res < 0)
         {
-            *ptr = inw(0x1F0); // Data port.
-            ptr++;
+            goto out;
         }
+
+        outsw(0x1F0, ptr, DISK_SECTOR_SIZE / sizeof(uint16_t));
+        ptr += DISK_SECTOR_SIZE;
     }
 
-    return 0;
+    // One more interrupt once the last sector is written.
+    res = disk_wait(true, false);
+
+out:
+    return res;
+}
+
+static int disk_flush_cache()
+{ // Make the drive commit its write cache, 0xE7 - FLUSH CACHE.
+    outb(0x1F7, 0xE7);
+    return disk_wait(true, false);
 }
 
 void disk_init()
@@ -49,6 +182,14 @@ void disk_init()
     disk.type = PHYSICAL_HARD_DISK_TYPE;
     disk.sector_size = DISK_SECTOR_SIZE;
     disk.id = 0; // Default ID for our disk.
+    outb(0x3F6, 0x02); // Device control, set nIEN, the drive is polled during boot.
+    wait_queue_init(&disk_irq.waiters);
+    if (ide_dma_init() == 0)
+    {
+        print("Using bus master DMA for the disk.\n");
+    }
+
+    disk_cache_init();
     disk.fs = fs_resolve(&disk);
 }
 
@@ -63,10 +204,66 @@ struct disk *get_disk(int index)
 
 int disk_read_blocks(struct disk *idisk, int lba, int sectors, void *buf)
 {
+    int res = 0;
+    if (idisk != &disk)
+    {
+        return -EIO;
+    }
+
+    // Large reads take several commands.
+    while (sectors > 0)
+    {
+        int count = (sectors > DISK_MAX_SECTORS_PER_COMMAND) ? DISK_MAX_SECTORS_PER_COMMAND : sectors;
+        res = ide_dma_read(lba, count, buf);
+        if (res < 0)
+        { // No DMA for this buffer or the transfer failed, the CPU does it.
+            res = disk_read_sectors(lba, count, buf);
+        }
+
+        if (res < 0)
+        {
+            break;
+        }
+
+        lba += count;
+        sectors -= count;
+        buf += count * DISK_SECTOR_SIZE;
+    }
+
+    return res;
+}
+
+int disk_write_blocks(struct disk *idisk, int lba, int sectors, const void *buf)
+{
+    int res = 0;
     if (idisk != &disk)
     {
         return -EIO;
     }
 
-    return disk_read_sectors(lba, sectors, buf);
+    while (sectors > 0)
+    {
+        int count = (sectors > DISK_MAX_SECTORS_PER_COMMAND) ? DISK_MAX_SECTORS_PER_COMMAND : sectors;
+        res = ide_dma_write(lba, count, buf);
+        if (res < 0)
+        {
+            res = disk_write_sectors(lba, count, buf);
+        }
+
+        if (res < 0)
+        {
+            break;
+        }
+
+        lba += count;
+        sectors -= count;
+        buf += count * DISK_SECTOR_SIZE;
+    }
+
+    if (res == 0)
+    {
+        res = disk_flush_cache();
+    }
+
+    return res;
 }
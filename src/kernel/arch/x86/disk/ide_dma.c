@@ -0,0 +1,169 @@
+#include <disk/ide_dma.h>
+#include <disk/disk.h>
+#include <pci/pci.h>
+#include <memory/frame.h>
+#include <memory/paging.h>
+#include <io.h>
+#include <errno.h>
+#include <video.h>
+
+struct ide_dma
+{
+    bool available;
+    uint16_t base;            // First bus master port of the primary channel.
+    struct ide_dma_prd *prdt; // Page frame, physical and virtual addresses are the same.
+    bool failed;              // The controller was found, then given up on.
+};
+
+static struct ide_dma dma;
+
+int ide_dma_init()
+{
+    int res = 0;
+    struct pci_device controller;
+    dma.available = false;
+
+    res = pci_find_device(PCI_CLASS_MASS_STORAGE, PCI_SUBCLASS_IDE, &controller);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    uint32_t bar = pci_get_bar(&controller, IDE_DMA_BAR);
+    if (!(controller.prog_if & IDE_PROG_IF_BUS_MASTER) || !(bar & PCI_BAR_IS_IO))
+    {
+        res = -ENODEV;
+        goto out;
+    }
+
+    dma.prdt = frame_alloc();
+    if (dma.prdt == NULL)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    dma.base = bar & PCI_BAR_IO_ADDRESS_MASK;
+    pci_enable_command(&controller, PCI_COMMAND_IO_SPACE | PCI_COMMAND_BUS_MASTER);
+    dma.available = true;
+
+out:
+    return res;
+}
+
+bool ide_dma_is_available()
+{
+    return dma.available;
+}
+
+bool ide_dma_has_failed()
+{
+    return dma.failed;
+}
+
+static bool ide_dma_can_reach(const void *buf, size_t total_bytes)
+{ // The controller needs physical addresses, only the identity mapped
+  // kernel memory has them without a page walk.
+    uint32_t address = (uint32_t)buf;
+    return (address % 2) == 0 && address + total_bytes <= USER_SPACE_START;
+}
+
+static void ide_dma_build_prdt(const void *buf, size_t total_bytes)
+{
+    uint32_t address = (uint32_t)buf;
+    struct ide_dma_prd *prd = dma.prdt;
+    while (total_bytes > 0)
+    {
+        size_t chunk = IDE_DMA_PRD_MAX_BYTES - (address % IDE_DMA_PRD_MAX_BYTES);
+        chunk = (chunk > total_bytes) ? total_bytes : chunk;
+        prd->address = address;
+        prd->total_bytes = chunk & 0xFFFF;
+        prd->flags = 0;
+
+        address += chunk;
+        total_bytes -= chunk;
+        prd++;
+    }
+
+    (prd - 1)->flags = IDE_DMA_PRD_END_OF_TABLE;
+}
+
+static int ide_dma_transfer(int lba, int sectors, const void *buf, bool read)
+{
+    int res = 0;
+    size_t total_bytes = sectors * DISK_SECTOR_SIZE;
+    if (!dma.available || sectors <= 0 || sectors > DISK_MAX_SECTORS_PER_COMMAND ||
+        !ide_dma_can_reach(buf, total_bytes))
+    {
+        return -ENODEV;
+    }
+
+    ide_dma_build_prdt(buf, total_bytes);
+    outb(dma.base + IDE_DMA_REGISTER_COMMAND, 0);
+    outl(dma.base + IDE_DMA_REGISTER_PRDT, (uint32_t)dma.prdt);
+    outb(dma.base + IDE_DMA_REGISTER_STATUS, IDE_DMA_STATUS_ERROR | IDE_DMA_STATUS_INTERRUPT);
+
+    outb(0x1F6, (lba >> 24) | 0b11100000);    // Drive and bit 24 - 27 of LBA.
+    outb(0x1F2, sectors);                     // Number of sectors, 0 means 256.
+    outb(0x1F3, (uint8_t)(lba & 0b11111111)); // Bit 0 - 7 of LBA.
+    outb(0x1F4, (uint8_t)(lba >> 8));         // Bit 8 - 15 of LBA.
+    outb(0x1F5, (uint8_t)(lba >> 16));        // Bit 16 - 23 of LBA.
+    outb(0x1F7, read ? 0xC8 : 0xCA);          // 0xC8 - READ DMA, 0xCA - WRITE DMA.
+
+    uint8_t command = read ? IDE_DMA_COMMAND_READ : 0;
+    outb(dma.base + IDE_DMA_REGISTER_COMMAND, command | IDE_DMA_COMMAND_START);
+
+    // The drive raises its interrupt when it is done, the engine flags
+    // failures. Sleep through the transfer if the drive interrupts. While
+    // it is polled (nIEN set during boot) the interrupt bit never comes,
+    // the engine going inactive is the end of the transfer then.
+    disk_wait_for_interrupt();
+    uint8_t status = inb(dma.base + IDE_DMA_REGISTER_STATUS);
+    int polls = 0;
+    while ((status & IDE_DMA_STATUS_ACTIVE) &&
+           !(status & (IDE_DMA_STATUS_INTERRUPT | IDE_DMA_STATUS_ERROR)) &&
+           polls < IDE_DMA_MAX_POLLS)
+    {
+        status = inb(dma.base + IDE_DMA_REGISTER_STATUS);
+        polls++;
+    }
+
+    outb(dma.base + IDE_DMA_REGISTER_COMMAND, command);
+    if (polls == IDE_DMA_MAX_POLLS)
+    { // Do not trust the controller again, the rest goes through PIO.
+        print("IDE DMA transfer timed out, using PIO.\n");
+        dma.available = false;
+        dma.failed = true;
+        res = -ETIMEDOUT;
+        goto out;
+    }
+
+    // The drive side is done once it is not busy, this also acknowledges
+    // its interrupt and checks ERR and DF.
+    res = disk_wait_until_ready();
+    if (res == 0 && (status & IDE_DMA_STATUS_ERROR))
+    {
+        res = -EIO;
+    }
+
+out:
+    outb(dma.base + IDE_DMA_REGISTER_STATUS, IDE_DMA_STATUS_ERROR | IDE_DMA_STATUS_INTERRUPT);
+
+    if (res < 0)
+    { // The drive may still be busy with the DMA command, it has to drop
+      // it before the caller can retry with PIO.
+        disk_reset();
+    }
+
+    return res;
+}
+
+int ide_dma_read(int lba, int sectors, void *buf)
+{
+    return ide_dma_transfer(lba, sectors, buf, true);
+}
+
+int ide_dma_write(int lba, int sectors, const void *buf)
+{
+    return ide_dma_transfer(lba, sectors, buf, false);
+}
@@ -1,6 +1,8 @@
 #include <memory/kheap.h>
 #include <stdbool.h>
+#include <string.h>
 #include <disk/stream.h>
+#include <disk/cache.h>
 #include <video.h>
 
 struct disk_stream *create_disk_stream(int disk_id)
@@ -23,39 +25,66 @@ int disk_stream_seek(struct disk_stream *stream, int pos)
     return 0;
 }
 
-int disk_stream_read(struct disk_stream *stream, void *buf, int total)
-{
-    bool need_to_read_more_than_one_sector = (total > DISK_SECTOR_SIZE);
+static int disk_stream_read_partial(struct disk_stream *stream, char *buf, int total)
+{ // Part of a single sector, through a bounce buffer.
+    char tmp_buf[DISK_SECTOR_SIZE];
     int sector = stream->pos / DISK_SECTOR_SIZE;
     int offset = stream->pos % DISK_SECTOR_SIZE;
-    char tmp_buf[DISK_SECTOR_SIZE];
-    int result = 0;
-
-    // Read a block.
-    result = disk_read_blocks(stream->disk, sector, 1, tmp_buf);
-    if (result < 0)
+    int res = disk_cache_read(stream->disk, sector, 1, tmp_buf);
+    if (res < 0)
     {
-        goto out;
+        return res;
     }
 
-    int total_to_read = need_to_read_more_than_one_sector ? DISK_SECTOR_SIZE : total;
+    memcpy(buf, tmp_buf + offset, total);
+    stream->pos += total;
+    return 0;
+}
 
-    for (int i = 0; i < total_to_read; i++)
+int disk_stream_read(struct disk_stream *stream, void *buf, int total)
+{
+    int res = 0;
+    char *out = buf;
+
+    // Unaligned head, up to the next sector boundary.
+    int offset = stream->pos % DISK_SECTOR_SIZE;
+    if (offset != 0 && total > 0)
     {
-        *(char *)buf++ = tmp_buf[offset + i];
+        int head = DISK_SECTOR_SIZE - offset;
+        head = (head > total) ? total : head;
+        res = disk_stream_read_partial(stream, out, head);
+        if (res < 0)
+        {
+            goto out;
+        }
+
+        out += head;
+        total -= head;
     }
 
-    // Adjust the stream position.
-    stream->pos += total_to_read;
+    // Whole sectors go straight to the caller, in one read.
+    int sectors = total / DISK_SECTOR_SIZE;
+    if (sectors > 0)
+    {
+        res = disk_cache_read(stream->disk, stream->pos / DISK_SECTOR_SIZE, sectors, out);
+        if (res < 0)
+        {
+            goto out;
+        }
+
+        stream->pos += sectors * DISK_SECTOR_SIZE;
+        out += sectors * DISK_SECTOR_SIZE;
+        total -= sectors * DISK_SECTOR_SIZE;
+    }
 
-    // Recursive until read full `total` bytes.
-    if (need_to_read_more_than_one_sector)
+    // Tail, the start of one more sector.
+    if (total > 0)
     {
-        result = disk_stream_read(stream, buf, (total - total_to_read));
+        res = disk_stream_read_partial(stream, out, total);
     }
 
 out:
-    return result;
+    return res;
 }
 
 void release_disk_stream(struct disk_stream *stream)
@@ -130,6 +130,7 @@ struct filesystem fat16_fs =
         open : fat16_open,
         resolve : fat16_resolve,
         read : fat16_read,
+        pread : fat16_pread,
         seek : fat16_seek,
         stat : fat16_stat,
         close : fat16_close
@@ -705,6 +706,35 @@ out:
     return res;
 }
 
+int fat16_pread(struct disk *disk, void *p, uint32_t size, uint32_t offset, char *out)
+{
+    int res = 0;
+    struct fat_file_descriptor *fat_desc = p;
+    struct fat_item *desc_item = fat_desc->item;
+    if (desc_item->type != FAT_ITEM_TYPE_FILE)
+    {
+        res = -EINVAL;
+        goto out;
+    }
+
+    struct fat_directory_item *item = desc_item->item;
+    if (offset >= item->filesize || size > item->filesize - offset)
+    {
+        res = -EIO;
+        goto out;
+    }
+
+    res = fat16_read_internal(disk, fat16_get_first_cluster(item), offset, size, out);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    res = size;
+out:
+    return res;
+}
+
 int fat16_seek(void *p, uint32_t offset, file_seek_mode seek_mode)
 {
     int res = 0;
@@ -774,6 +804,7 @@ int fat16_stat(struct disk *disk, void *p, struct file_stat *stat)
     stat->last_mod_time = item->last_mod_time;
     stat->last_mod_date = item->last_mod_date;
     stat->filesize = item->filesize;
+    stat->inode = fat16_get_first_cluster(item);
 
 out:
     return res;
@@ -41,6 +41,7 @@ static int make_new_file_descriptor(struct file_descriptor **fd_out)
             struct file_descriptor *fd = kzalloc(sizeof(struct file_descriptor));
             // File descriptor will start at 1.
             fd->index = i + 1;
+            fd->refcount = 1;
             file_descriptors[i] = fd;
             *fd_out = fd;
             res = 0;
@@ -242,6 +243,22 @@ out:
     return res;
 }
 
+int fpread(int fd, void *ptr, uint32_t size, uint32_t offset)
+{
+    int res = 0;
+    struct file_descriptor *desc = get_file_descriptor(fd);
+    if (desc == NULL || size == 0)
+    {
+        res = -EINVAL;
+        goto out;
+    }
+
+    res = desc->fs->pread(desc->disk, desc->p, size, offset, (char *)ptr);
+
+out:
+    return res;
+}
+
 int fseek(int fd, int offset, file_seek_mode whence)
 {
     int res = 0;
@@ -269,6 +286,7 @@ int fstat(int fd, struct file_stat *stat)
     }
 
     res = desc->fs->stat(desc->disk, desc->p, stat);
+    stat->device = desc->disk->id;
 
 out:
     return res;
@@ -285,6 +303,11 @@ int fclose(int fd)
         goto out;
     }
 
+    if (--desc->refcount > 0)
+    { // Still used by someone else.
+        goto out;
+    }
+
     res = desc->fs->close(desc->p);
     if (res < 0)
     {
@@ -294,6 +317,23 @@ int fclose(int fd)
     // Free file descriptor make by vfs open function.
     release_file_descriptor(desc);
 
+out:
+    return res;
+}
+
+int fref(int fd)
+{
+    int res = 0;
+
+    struct file_descriptor *desc = get_file_descriptor(fd);
+    if (desc == NULL)
+    {
+        res = -EINVAL;
+        goto out;
+    }
+
+    desc->refcount++;
+
 out:
     return res;
 }
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include <fs/page_cache.h>
+#include <fs/file.h>
+#include <memory/frame.h>
+#include <memory/kheap.h>
+#include <memory/paging.h>
+#include <errno.h>
+
+static struct page_cache_page *page_cache_buckets[PAGE_CACHE_TOTAL_BUCKETS];
+
+static uint32_t page_cache_hash(uint32_t inode, uint32_t offset)
+{
+    return (inode * 31 + offset / PAGING_PAGE_SIZE) % PAGE_CACHE_TOTAL_BUCKETS;
+}
+
+static struct page_cache_page *page_cache_find(uint32_t device, uint32_t inode, uint32_t offset)
+{
+    struct page_cache_page *page = page_cache_buckets[page_cache_hash(inode, offset)];
+    while (page != NULL)
+    {
+        if (page->device == device && page->inode == inode && page->offset == offset)
+        {
+            break;
+        }
+
+        page = page->next;
+    }
+
+    return page;
+}
+
+static int page_cache_read(int fd, struct file_stat *stat, uint32_t offset, void *frame)
+{
+    int res = 0;
+    if (offset >= stat->filesize)
+    {
+        goto out;
+    }
+
+    uint32_t size = stat->filesize - offset;
+    if (size > PAGING_PAGE_SIZE)
+    {
+        size = PAGING_PAGE_SIZE;
+    }
+
+    // Faults must not move the file position of the descriptor.
+    res = fpread(fd, frame, size, offset);
+    if (res > 0)
+    {
+        res = 0;
+    }
+
+out:
+    return res;
+}
+
+void *page_cache_get(int fd, uint32_t offset)
+{
+    int res = 0;
+    void *frame = NULL;
+    struct page_cache_page *page = NULL;
+    struct file_stat stat;
+    if (offset % PAGING_PAGE_SIZE)
+    {
+        res = -EINVAL;
+        goto out;
+    }
+
+    res = fstat(fd, &stat);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    page = page_cache_find(stat.device, stat.inode, offset);
+    if (page != NULL)
+    {
+        res = frame_ref(page->frame);
+        goto out;
+    }
+
+    frame = frame_alloc_zeroed();
+    if (frame == NULL && page_cache_shrink() > 0)
+    {
+        frame = frame_alloc_zeroed();
+    }
+
+    if (frame == NULL)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    res = page_cache_read(fd, &stat, offset, frame);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    page = kzalloc(sizeof(struct page_cache_page));
+    if (page == NULL)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    uint32_t bucket = page_cache_hash(stat.inode, offset);
+    page->device = stat.device;
+    page->inode = stat.inode;
+    page->offset = offset;
+    page->frame = frame;
+    page->next = page_cache_buckets[bucket];
+    page_cache_buckets[bucket] = page;
+
+    // The reference from the allocation stays with the cache.
+    res = frame_ref(frame);
+
+out:
+    if (res < 0)
+    {
+        if (page == NULL && frame != NULL)
+        {
+            frame_free(frame);
+        }
+
+        return ERR_PTR(res);
+    }
+
+    return page->frame;
+}
+
+int page_cache_shrink()
+{
+    int total = 0;
+    for (int i = 0; i < PAGE_CACHE_TOTAL_BUCKETS; i++)
+    {
+        struct page_cache_page **link = &page_cache_buckets[i];
+        while (*link != NULL)
+        {
+            struct page_cache_page *page = *link;
+            if (frame_get_refcount(page->frame) > 1)
+            {
+                link = &page->next;
+                continue;
+            }
+
+            *link = page->next;
+            frame_free(page->frame);
+            kfree(page);
+            total++;
+        }
+    }
+
+    return total;
+}
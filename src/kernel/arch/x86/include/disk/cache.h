@@ -0,0 +1,42 @@
+#pragma once
+#include <types.h>
+#include <disk/disk.h>
+
+// Sectors recently read from the disks, kept in memory so hot sectors (the
+// FAT, directories, the boot sector) are only read from the device once.
+// Blocks are found through a hash of (disk, LBA), and the least recently
+// used block is reused when the cache is full.
+#define DISK_CACHE_TOTAL_BLOCKS     256 // 128 KiB of sectors.
+#define DISK_CACHE_TOTAL_BUCKETS    64
+
+// Longer runs of missing sectors are read straight into the caller's
+// buffer and not cached, so streaming a large file does not push the hot
+// sectors out.
+#define DISK_CACHE_MAX_CACHED_RUN   8
+
+struct disk_cache_block
+{
+    struct disk *disk;               // NULL if the block holds nothing.
+    int lba;
+    struct disk_cache_block *next;   // Next block in the same bucket.
+    struct disk_cache_block *newer;  // LRU list, the head is the most recently used.
+    struct disk_cache_block *older;
+    char data[DISK_SECTOR_SIZE];
+};
+
+struct disk_cache_stats
+{
+    uint32_t hits;      // Sectors served from the cache.
+    uint32_t misses;    // Sectors read from the disk.
+    uint32_t evictions; // Cached sectors dropped for others.
+};
+
+void disk_cache_init();
+
+// Read `sectors` sectors from `lba`, through the cache.
+int disk_cache_read(struct disk *disk, int lba, int sectors, void *buf);
+
+// Write `sectors` sectors to `lba`, the cache keeps what was written.
+int disk_cache_write(struct disk *disk, int lba, int sectors, const void *buf);
+
+void disk_cache_get_stats(struct disk_cache_stats *stats);
@@ -1,7 +1,20 @@
 #pragma once
 
 #define DISK_SECTOR_SIZE 512
+#define DISK_MAX_SECTORS_PER_COMMAND 256 // The sector count register is 8 bits, 0 means 256.
 #define PHYSICAL_HARD_DISK_TYPE 0
+
+// ATA status register bits.
+#define DISK_STATUS_ERR 0x01
+#define DISK_STATUS_DRQ 0x08 // The drive has data or wants data.
+#define DISK_STATUS_DF  0x20 // Drive fault.
+#define DISK_STATUS_BSY 0x80
+
+// Bounds on a wait for the drive: polls of the status register, and
+// interrupts of any kind slept through (the BIOS timer alone ticks 18.2
+// times a second).
+#define DISK_MAX_STATUS_POLLS    0x00400000
+#define DISK_MAX_WAIT_INTERRUPTS 256
 typedef unsigned int disk_t;
 
 struct filesystem;
@@ -17,3 +30,20 @@ struct disk
 void disk_init();
 struct disk *get_disk(int index);
 int disk_read_blocks(struct disk *idisk, int lba, int sectors, void *buf);
+int disk_write_blocks(struct disk *idisk, int lba, int sectors, const void *buf);
+
+// The drive is polled until the interrupt descriptor table is loaded, it
+// interrupts (IRQ 14) from then on and waiting tasks sleep.
+void disk_enable_interrupts();
+void disk_interrupt_handler();
+
+// Sleep until the drive interrupts. -ENODEV while the drive is polled.
+int disk_wait_for_interrupt();
+
+// Poll until the drive is no longer busy. 0, -EIO if it reports an error,
+// or -ETIMEDOUT.
+int disk_wait_until_ready();
+
+// Software reset of the drive (SRST), it drops a command it is still busy
+// with. 0 once it is ready again, -EIO or -ETIMEDOUT.
+int disk_reset();
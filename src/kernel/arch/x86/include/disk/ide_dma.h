@@ -0,0 +1,50 @@
+#pragma once
+#include <types.h>
+#include <stdbool.h>
+
+// Bus master IDE, as on the PIIX3/PIIX4 controllers (and QEMU). The
+// controller moves sectors between the drive and memory by itself,
+// following a table of physical memory regions (PRD table), the CPU only
+// starts the transfer and waits for it. The bus master registers of the
+// primary channel are the first 8 I/O ports of BAR4 of the controller.
+#define IDE_DMA_BAR                     4
+#define IDE_PROG_IF_BUS_MASTER          0x80 // The controller can do bus master DMA.
+
+#define IDE_DMA_REGISTER_COMMAND        0x00
+#define IDE_DMA_REGISTER_STATUS         0x02
+#define IDE_DMA_REGISTER_PRDT           0x04
+
+#define IDE_DMA_COMMAND_START           0x01
+#define IDE_DMA_COMMAND_READ            0x08 // Direction, set when the drive writes to memory.
+#define IDE_DMA_STATUS_ACTIVE           0x01
+#define IDE_DMA_STATUS_ERROR            0x02
+#define IDE_DMA_STATUS_INTERRUPT        0x04 // The drive is done, cleared by writing it back.
+
+// Every region is at most 64 KiB and can not cross a 64 KiB boundary, the
+// last region of the table is flagged. The table lives in one page frame.
+#define IDE_DMA_PRD_MAX_BYTES           0x10000
+#define IDE_DMA_PRD_END_OF_TABLE        0x8000
+
+// Status polls before a transfer is given up, a few seconds of port reads.
+#define IDE_DMA_MAX_POLLS               0x00400000
+
+struct ide_dma_prd
+{
+    uint32_t address;     // Physical address of the region, even.
+    uint16_t total_bytes; // 0 means 64 KiB.
+    uint16_t flags;
+} __attribute__((packed));
+
+// Look for the IDE controller on the PCI bus, 0 if DMA can be used.
+int ide_dma_init();
+
+bool ide_dma_is_available();
+
+// DMA was available and turned off after a transfer timed out.
+bool ide_dma_has_failed();
+
+// Transfer `sectors` sectors (at most 256) at `lba` between the primary
+// master and `buf`. -ENODEV means the caller should use PIO instead.
+int ide_dma_read(int lba, int sectors, void *buf);
+
+int ide_dma_write(int lba, int sectors, const void *buf);
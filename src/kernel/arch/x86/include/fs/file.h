@@ -32,6 +32,7 @@ struct path_part;
 struct file_stat;
 typedef void *(*FS_OPEN_FUNCTION)(struct disk *disk, struct path_part *path, file_mode mode);
 typedef int (*FS_READ_FUNCTION)(struct disk *disk, void *p, uint32_t size, uint32_t nmemb, char *out);
+typedef int (*FS_PREAD_FUNCTION)(struct disk *disk, void *p, uint32_t size, uint32_t offset, char *out);
 typedef int (*FS_SEEK_FUNCTION)(void *p, uint32_t offset, file_seek_mode seek_mode);
 typedef int (*FS_STAT_FUNCTION)(struct disk *disk, void *p, struct file_stat *stat);
 typedef int (*FS_CLOSE_FUNCTION)(void *p);
@@ -45,6 +46,7 @@ struct filesystem
     FS_RESOLVE_FUNCTION resolve;
     FS_OPEN_FUNCTION open;
     FS_READ_FUNCTION read;
+    FS_PREAD_FUNCTION pread; // Read at an offset, the file position stays where it is.
     FS_SEEK_FUNCTION seek;
     FS_STAT_FUNCTION stat;
     FS_CLOSE_FUNCTION close;
@@ -56,6 +58,7 @@ struct file_descriptor
     struct filesystem *fs;
     struct disk *disk; // The disk that the file descriptor should be on.
     void *p;           // Private data for internal file descriptor.
+    int refcount;      // Users of the descriptor, it is closed with the last one.
 };
 
 struct file_stat
@@ -71,6 +74,8 @@ struct file_stat
     uint16_t last_mod_time;
     uint16_t last_mod_date;
     uint32_t filesize;
+    uint32_t device; // Disk of the file.
+    uint32_t inode;  // Identifies the file on its disk.
 };
 
 void fs_init();
@@ -79,6 +84,12 @@ struct filesystem *fs_resolve(struct disk *disk);
 
 int fopen(const char *file_name, const char *mode_of_operation);
 int fread(int fd, void *ptr, uint32_t size, uint32_t nmemb);
+// Read `size` bytes at `offset` without moving the file position, return
+// the number of bytes read.
+int fpread(int fd, void *ptr, uint32_t size, uint32_t offset);
 int fseek(int fd, int offset, file_seek_mode whence);
 int fstat(int fd, struct file_stat *stat);
-int fclose(int fd);
\ No newline at end of file
+int fclose(int fd);
+
+// Add a user to an open file, every user closes it once.
+int fref(int fd);
\ No newline at end of file
@@ -0,0 +1,23 @@
+#pragma once
+#include <types.h>
+
+// Pages of files mapped into processes. A page is read from the disk once
+// and its frame is shared by every process mapping the same file, the
+// cache keeps one reference to the frame and each mapping another.
+#define PAGE_CACHE_TOTAL_BUCKETS 64
+
+struct page_cache_page
+{
+    uint32_t device;              // Disk of the file.
+    uint32_t inode;               // File on the disk.
+    uint32_t offset;              // Page aligned offset in the file.
+    void *frame;
+    struct page_cache_page *next; // Next page in the same bucket.
+};
+
+// Frame holding the page of the open file `fd` at `offset`, with a
+// reference taken for the caller. Past the end of the file it reads as zeros.
+void *page_cache_get(int fd, uint32_t offset);
+
+// Drop the pages nobody maps anymore, return how many frames were freed.
+int page_cache_shrink();
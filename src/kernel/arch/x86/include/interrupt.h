@@ -6,7 +6,13 @@
 #define KERNEL_DATA_SELECTOR 0x10
 
 #define DIVIDE_BY_ZERO_INTERRUPT_NUMBER  0x00
+#define PAGE_FAULT_INTERRUPT_NUMBER 0x0E
 #define SYSTEM_CALL_INTERRUPT_NUMBER 0x80
+
+// Hardware interrupts, the PICs are remapped past the CPU exceptions.
+#define PIC_MASTER_VECTOR_OFFSET 0x20
+#define PIC_SLAVE_VECTOR_OFFSET  0x70
+#define DISK_INTERRUPT_NUMBER    (PIC_SLAVE_VECTOR_OFFSET + 6) // IRQ 14.
 typedef void (*INTERRUPT_CALLBACK_FUNCTION)();
 
 /**
@@ -59,4 +65,11 @@ void init_interrupt_descriptor_table();
 void enable_interrupt();
 void disable_interrupt();
 
-extern void syscall_wrapper();
\ No newline at end of file
+extern void syscall_wrapper();
+
+extern void page_fault_wrapper();
+
+extern void disk_interrupt_wrapper();
+
+// Enable interrupts, halt until one arrives, disable them again.
+extern void wait_for_interrupt();
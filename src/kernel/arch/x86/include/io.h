@@ -13,4 +13,22 @@ extern uint16_t inw(uint16_t port);
 extern void outb(uint16_t port, uint8_t val);
 
 /* Output word to port. */
-extern void outw(uint16_t port, uint16_t val);
\ No newline at end of file
+extern void outw(uint16_t port, uint16_t val);
+
+/* Get input double word from port. */
+extern uint32_t inl(uint16_t port);
+
+/* Output double word to port. */
+extern void outl(uint16_t port, uint32_t val);
+
+/* Read `count` words from port into buffer. */
+extern void insw(uint16_t port, void *buf, uint32_t count);
+
+/* Write `count` words from buffer to port. */
+extern void outsw(uint16_t port, const void *buf, uint32_t count);
+
+/* Read `count` double words from port into buffer. */
+extern void insl(uint16_t port, void *buf, uint32_t count);
+
+/* Write `count` double words from buffer to port. */
+extern void outsl(uint16_t port, const void *buf, uint32_t count);
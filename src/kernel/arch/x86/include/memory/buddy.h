@@ -0,0 +1,45 @@
+#pragma once
+#include <types.h>
+
+// Binary buddy allocator. The memory is managed in blocks of 4 KiB and
+// every allocation is a run of 2^order blocks, aligned on its own size
+// relative to the start of the heap. A free run is merged back with its
+// buddy (the other half of its parent run) as soon as both are free.
+#define BUDDY_BLOCK_SIZE_BYTES    0x00001000
+#define BUDDY_MAX_ORDER           15 // 2^15 blocks = 128 MiB.
+#define BUDDY_TOTAL_ORDERS        (BUDDY_MAX_ORDER + 1)
+
+// Every block has an entry, only the first block of a run is marked as
+// a head, it holds the order of the run and whether the run is free.
+#define BUDDY_BLOCK_IS_HEAD       0b10000000
+#define BUDDY_BLOCK_IS_FREE       0b01000000
+#define BUDDY_BLOCK_ORDER_MASK    0b00011111
+
+typedef unsigned char buddy_block_entry;
+
+struct buddy_free_block
+{ // Header stored in the first block of every free run.
+    struct buddy_free_block *next;
+    struct buddy_free_block *prev;
+};
+
+struct buddy_heap
+{
+    void *start_address;
+    size_t total_blocks;
+    buddy_block_entry *entries;
+    struct buddy_free_block *free_lists[BUDDY_TOTAL_ORDERS];
+    uint32_t free_orders; // Bit `n` is set if the free list of order `n` is not empty.
+};
+
+int buddy_create(struct buddy_heap *heap, void *start, void *end, buddy_block_entry *entries);
+
+void *buddy_malloc(struct buddy_heap *heap, size_t size);
+
+void buddy_free(struct buddy_heap *heap, void *ptr);
+
+void *buddy_realloc(struct buddy_heap *heap, void *ptr, size_t size);
+
+size_t buddy_get_allocation_size(struct buddy_heap *heap, void *ptr);
+
+size_t buddy_get_largest_free_block(struct buddy_heap *heap);
@@ -0,0 +1,75 @@
+#pragma once
+#include <types.h>
+
+// The boot sector asks the BIOS for the physical memory map (INT 15h,
+// E820) and leaves it in conventional memory, see `boot/detect_memory_e820.asm`.
+#define E820_MAP_COUNT_ADDRESS          0x00000500
+#define E820_MAP_ENTRIES_ADDRESS        0x00000504
+#define E820_MAX_ENTRIES                128
+#define E820_MEMORY_TYPE_USABLE         1
+
+// Page frames are 4 KiB of physical memory. Everything below
+// `FRAME_ALLOCATOR_START_ADDRESS` belongs to the kernel image, its stacks
+// and the boot time structures, frames are only handed out above it.
+#define FRAME_SIZE_BYTES                0x00001000
+#define FRAME_ALLOCATOR_START_ADDRESS   0x01000000
+
+// Memory assumed to exist when the BIOS gives us no memory map.
+#define FRAME_ALLOCATOR_FALLBACK_END    0x07400000
+
+// Frames cleared ahead of time, so page tables and zeroed allocations do
+// not pay for the clearing. The pool is refilled from the idle loop, a
+// batch at a time, and holds enough frames for a full set of page tables.
+#define FRAME_ZEROED_POOL_SIZE          1024
+#define FRAME_ZEROED_POOL_REFILL_BATCH  16
+
+struct e820_entry
+{
+    uint64_t base;
+    uint64_t length;
+    uint32_t type;
+    uint32_t acpi_attributes;
+} __attribute__((packed));
+
+// Every allocated frame has a reference count, frames shared between
+// address spaces (copy on write) are only freed by their last user.
+#define FRAME_MAX_REFCOUNT              0xFF
+
+typedef uint8_t frame_refcount;
+
+struct frame_allocator
+{
+    uint32_t *bitmap;          // Bit is set if the frame is in use or is not usable RAM.
+    frame_refcount *refcounts; // Users of every frame, 0 if the frame is not allocated.
+    size_t total_frames;       // Frames from address 0 up to the end of usable RAM.
+    size_t free_frames;        // Frames that can still be allocated.
+    size_t next_free_word;     // Word of the bitmap where the next search starts.
+    void *zeroed_pool[FRAME_ZEROED_POOL_SIZE];
+    size_t total_zeroed;       // Frames in `zeroed_pool`, taken out of the bitmap already.
+};
+
+void frame_allocator_init();
+
+void *frame_alloc();
+
+void *frame_alloc_contiguous(size_t total_frames);
+
+// Allocate a frame that is filled with zeros.
+void *frame_alloc_zeroed();
+
+// Clear up to `max_frames` free frames into the zeroed pool, return how
+// many were added.
+int frame_refill_zeroed_pool(size_t max_frames);
+
+// Drop a reference to the frame, the frame is released with the last one.
+void frame_free(void *frame);
+
+// Add a reference to an allocated frame.
+int frame_ref(void *frame);
+
+int frame_get_refcount(void *frame);
+
+size_t frame_get_total_free();
+
+// Frames from address 0 up to the end of usable RAM, free or not.
+size_t frame_get_total();
@@ -14,23 +14,71 @@
 // more information, check the standard x86 memory 
 // map.
 #define HEAP_TABLE_ADDRESS        0x00007E00
+#define HEAP_TABLE_MAX_SIZE_BYTES 0x00078200
+
+// The heap table is either a byte map (one `heap_block_table_entry` per
+// block) or a pair of bitmaps: a free bitmap and a bitmap of the first
+// blocks of the allocations, which is 8 times smaller and is searched
+// 32 blocks at a time.
+#define HEAP_TABLE_TYPE_BYTE_MAP  0x00
+#define HEAP_TABLE_TYPE_BITMAP    0x01
+#define HEAP_BITMAP_TOTAL_WORDS(total_blocks) (((total_blocks) + 31) / 32)
+
+// Free runs of blocks are indexed by size, bucket `n` holds the runs
+// which length is in range [2^n, 2^(n+1)) blocks.
+#define HEAP_FREE_RUN_BUCKETS     32
 
 typedef unsigned char heap_block_table_entry;
 
 struct heap_table
 {
-    heap_block_table_entry *entries;
+    uint8_t type;
+    heap_block_table_entry *entries; // Entries of a byte map table.
+    uint32_t *free_bitmap;           // Bit is set if the block is free.
+    uint32_t *first_bitmap;          // Bit is set if the block starts an allocation.
     size_t total;
 };
 
+struct heap_free_run
+{ // Header stored in the first block of every free run. The last block
+  // of the run stores the run length in its last bytes, so a run can be
+  // found from both of its ends when neighbours are coalesced.
+    size_t total_blocks;
+    struct heap_free_run *next; // Next run in the same bucket.
+    struct heap_free_run *prev; // Previous run in the same bucket.
+};
+
+struct heap_stats
+{
+    uint32_t total_allocations;  // Successful allocations since creation.
+    uint32_t total_frees;        // Allocations given back since creation.
+    uint32_t failed_allocations; // Allocations that found no free run.
+    size_t bytes_requested;      // Sum of the sizes asked for.
+    size_t bytes_allocated;      // Sum of the sizes handed out, rounded up to blocks.
+    size_t blocks_in_use;
+    size_t peak_blocks_in_use;   // High-water mark of `blocks_in_use`.
+    size_t largest_free_run;     // In blocks, only filled by `heap_get_stats()`.
+};
+
 struct heap 
 {
     struct heap_table *table;
     void *start_address;
+    struct heap_free_run *free_runs[HEAP_FREE_RUN_BUCKETS];
+    uint32_t free_run_buckets; // Bit `n` is set if bucket `n` is not empty.
+    struct heap_stats stats;
 };
 
 int heap_create(struct heap *heap, void *start, void *end, struct heap_table *table);
 
 void *malloc(struct heap *heap, size_t size);
 
-void free(struct heap *heap, void *ptr);
\ No newline at end of file
+void free(struct heap *heap, void *ptr);
+
+void *realloc(struct heap *heap, void *ptr, size_t size);
+
+size_t heap_get_allocation_size(struct heap *heap, void *ptr);
+
+void heap_get_stats(struct heap *heap, struct heap_stats *stats);
+
+size_t heap_table_get_size_bytes(uint8_t type, size_t total_blocks);
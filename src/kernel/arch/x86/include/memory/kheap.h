@@ -1,10 +1,49 @@
 #pragma once
 #include <types.h>
 
-// We use 100MB for kernel heap and start 
-// at address 0x01000000 (RAM -- free for use).
-#define KERNEL_HEAP_SIZE_BYTES          0x06400000
-#define KERNEL_HEAP_START_ADDRESS       0x01000000
+// The kernel heap is carved out of the page frames at boot, so it only
+// covers RAM the BIOS reported. It takes `KERNEL_HEAP_MEMORY_SHARE` percent
+// of the free frames, at most `KERNEL_HEAP_MAX_SIZE_BYTES`, and the rest
+// stays with the frame allocator.
+#define KERNEL_HEAP_MAX_SIZE_BYTES      0x40000000
+#define KERNEL_HEAP_MIN_SIZE_BYTES      0x00400000
+#define KERNEL_HEAP_MEMORY_SHARE        50
+
+// Allocator that owns the kernel heap memory: the block table heap
+// (`heap.h`) or the binary buddy allocator (`buddy.h`).
+#define KERNEL_HEAP_BACKEND_BLOCK_TABLE 0
+#define KERNEL_HEAP_BACKEND_BUDDY       1
+#define KERNEL_HEAP_BACKEND             KERNEL_HEAP_BACKEND_BLOCK_TABLE
+
+// Representation of the kernel heap table, see `HEAP_TABLE_TYPE_*`.
+#define KERNEL_HEAP_TABLE_TYPE          HEAP_TABLE_TYPE_BITMAP
+
+// When set, allocations are also counted per call site (return address
+// of `kmalloc()`, `kzalloc()` or `krealloc()`).
+#define KHEAP_DEBUG                     0
+#define KHEAP_DEBUG_TOTAL_CALL_SITES    32
+
+struct slab_cache_stats;
+
+struct kheap_stats
+{
+    uint32_t total_allocations;  // Successful allocations and resizes since boot.
+    uint32_t total_frees;
+    uint32_t failed_allocations;
+    size_t bytes_requested;      // Sum of the sizes asked for since boot.
+    size_t bytes_allocated;      // Same, rounded up to slab objects or heap blocks.
+    size_t bytes_in_use;         // Rounded up size of the live allocations.
+    size_t peak_bytes_in_use;    // High-water mark of `bytes_in_use`.
+    size_t heap_size_bytes;
+    size_t largest_free_bytes;   // Largest heap allocation that can still succeed.
+};
+
+struct kheap_call_site
+{
+    void *caller;
+    uint32_t total_allocations;
+    size_t bytes_requested;
+};
 
 void kheap_init();
 
@@ -12,4 +51,16 @@ void *kmalloc(size_t size);
 
 void *kzalloc(size_t size);
 
-void kfree(void *ptr);
\ No newline at end of file
+void kfree(void *ptr);
+
+// Resize an allocation, keeping its content up to the smaller of both
+// sizes. Heap runs grow in place when the blocks after them are free.
+void *krealloc(void *ptr, size_t size);
+
+int kheap_get_slab_stats(int index, struct slab_cache_stats *stats);
+
+void kheap_get_stats(struct kheap_stats *stats);
+
+// Fill `site` with the call site at `index`, -ENOENT when there is none
+// or when `KHEAP_DEBUG` is off.
+int kheap_get_call_site(int index, struct kheap_call_site *site);
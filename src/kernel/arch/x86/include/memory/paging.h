@@ -1,15 +1,45 @@
 #pragma once
 #include <types.h>
 
+#define PAGING_IS_GLOBAL 0b100000000
+#define PAGING_IS_LARGE_PAGE 0b10000000
 #define PAGING_CACHE_DISABLED 0b00010000
 #define PAGING_WRITE_THROUGH 0b00001000
 #define PAGING_ACCESS_FROM_ALL 0b00000100
 #define PAGING_IS_WRITEABLE 0b00000010
 #define PAGING_IS_PRESENT 0b00000001
 
+// Available bit of a directory entry, set when the page table belongs to
+// the directory. Other tables are shared with the kernel directory.
+#define PAGING_PRIVATE_TABLE 0b1000000000
+
+// Available bit of a page table entry, set on pages that are shared
+// read only after a fork and get copied on the first write.
+#define PAGING_IS_COPY_ON_WRITE 0b10000000000
+
+// Flags that mean the same in a page table entry and a directory entry.
+#define PAGING_ENTRY_FLAGS_MASK 0b00011111
+
 #define PAGING_TOTAL_ENTRIES_PER_TABLE 1024
 #define PAGING_PAGE_SIZE 4096
 
+// Past this many pages, invalidating one page at a time costs more than
+// flushing the whole TLB.
+#define PAGING_INVALIDATE_PAGES_LIMIT 32
+
+// With PSE (CR4.PSE) a directory entry can map 4 MiB directly.
+#define PAGING_LARGE_PAGE_SIZE 0x400000
+#define PAGING_LARGE_PAGE_ADDRESS_MASK 0xFFC00000
+#define PAGING_DIRECTORY_INDEX(address) ((uint32_t)(address) / (PAGING_TOTAL_ENTRIES_PER_TABLE * PAGING_PAGE_SIZE))
+
+// Every address space shares the kernel page tables, except in the user
+// window. The user window starts empty and its page tables are allocated
+// when something gets mapped there. Outside of it, physical memory is
+// identity mapped for the kernel only, so interrupts and syscalls run on
+// the directory of the task without touching CR3.
+#define USER_SPACE_START 0x40000000
+#define USER_SPACE_END 0xC0000000
+
 struct paging_4GB_chunk
 {
     uint32_t *directory_entry;
@@ -17,8 +47,23 @@ struct paging_4GB_chunk
 
 extern void enable_paging();
 
+// TLB maintenance, for the address space that is loaded in CR3.
+extern void paging_invalidate_page(void *virt);
+extern void paging_flush_tlb();
+extern void paging_flush_global_tlb();
+void paging_invalidate_range(void *start, void *end);
+
+// Turn on 4 MiB pages if the CPU has them, call it before any address space is made.
+void paging_initialize_large_pages();
+
+// Turn on global pages if the CPU has them, kernel mappings made afterwards
+// stay in the TLB when CR3 changes.
+void paging_initialize_global_pages();
+
 struct paging_4GB_chunk *make_new_4GB_virtual_memory_address_space(uint8_t flags);
 
+struct paging_4GB_chunk *make_new_user_virtual_memory_address_space();
+
 void switch_to_kernel_page();
 
 void paging_install_kernel_page(struct paging_4GB_chunk *kernel_page);
@@ -38,6 +83,11 @@ int paging_map_page(struct paging_4GB_chunk *page,
                     void *phys,
                     int flags);
 
+int paging_map_large_page(struct paging_4GB_chunk *page,
+                          void *virt,
+                          void *phys,
+                          int flags);
+
 void *paging_align_address(void *ptr);
 
 uint32_t paging_get_entry_of_address(struct paging_4GB_chunk *page, void *virt);
@@ -0,0 +1,63 @@
+#pragma once
+#include <types.h>
+#include <stdbool.h>
+
+// Small kernel objects are served from per-size caches. Every cache carves
+// 4 KiB pages (one heap block each) into equally sized objects, the sizes
+// are powers of two from 16 bytes up to 1024 bytes. Anything bigger than
+// that goes straight to the block heap, behind the page header only one
+// 2048 byte object would fit in a page.
+#define SLAB_PAGE_SIZE        0x00001000
+#define SLAB_MIN_OBJECT_SIZE  16
+#define SLAB_MAX_OBJECT_SIZE  1024
+#define SLAB_TOTAL_CACHES     7
+#define SLAB_PAGE_MAGIC       0x51AB51AB
+
+typedef void *(*SLAB_PAGE_ALLOC_FUNCTION)();
+typedef void (*SLAB_PAGE_FREE_FUNCTION)(void *page);
+
+struct slab_object
+{ // A free object, the link is stored inside the object memory itself.
+    struct slab_object *next;
+};
+
+struct slab_cache;
+struct slab_page
+{ // Header at the start of every slab page, objects follow it.
+    uint32_t magic;
+    struct slab_cache *cache;      // Cache that owns the page.
+    struct slab_page *next;        // Next page in the partial list of the cache.
+    struct slab_page *prev;        // Previous page in the partial list of the cache.
+    struct slab_object *free_list; // Free objects of the page.
+    uint16_t in_use;               // Number of allocated objects.
+    uint16_t capacity;             // Number of objects the page can hold.
+};
+
+struct slab_cache_stats
+{
+    size_t object_size;
+    uint32_t total_pages;       // Pages currently owned by the cache.
+    uint32_t total_objects;     // Objects that fit in those pages.
+    uint32_t objects_in_use;    // Objects currently allocated.
+    uint32_t total_allocations; // Allocations since boot.
+    uint32_t total_frees;       // Frees since boot.
+};
+
+struct slab_cache
+{
+    size_t object_size;
+    struct slab_page *partial; // Pages with at least one free object.
+    struct slab_cache_stats stats;
+};
+
+void slab_init(SLAB_PAGE_ALLOC_FUNCTION alloc_page, SLAB_PAGE_FREE_FUNCTION free_page);
+
+void *slab_alloc(size_t size);
+
+void slab_free(void *ptr);
+
+size_t slab_get_object_size(void *ptr);
+
+bool slab_owns(void *ptr);
+
+int slab_get_cache_stats(int index, struct slab_cache_stats *stats);
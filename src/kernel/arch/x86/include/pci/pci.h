@@ -0,0 +1,56 @@
+#pragma once
+#include <types.h>
+
+// PCI configuration space, reached through configuration mechanism #1:
+// the address of a register goes to `PCI_CONFIG_ADDRESS_PORT`, then the
+// register is read or written 32 bits at a time at `PCI_CONFIG_DATA_PORT`.
+#define PCI_CONFIG_ADDRESS_PORT     0xCF8
+#define PCI_CONFIG_DATA_PORT        0xCFC
+#define PCI_CONFIG_ENABLE           0x80000000
+
+#define PCI_MAX_BUSES               256
+#define PCI_MAX_DEVICES             32
+#define PCI_MAX_FUNCTIONS           8
+#define PCI_INVALID_VENDOR_ID       0xFFFF
+
+// Registers of the configuration header.
+#define PCI_REGISTER_ID             0x00 // Device ID (high), vendor ID (low).
+#define PCI_REGISTER_COMMAND        0x04
+#define PCI_REGISTER_CLASS          0x08 // Class, subclass, programming interface, revision.
+#define PCI_REGISTER_HEADER_TYPE    0x0C // Header type is bits 16 - 23.
+#define PCI_REGISTER_BAR0           0x10
+#define PCI_TOTAL_BARS              6
+
+#define PCI_HEADER_IS_MULTI_FUNCTION 0x80
+#define PCI_COMMAND_IO_SPACE        0x0001
+#define PCI_COMMAND_BUS_MASTER      0x0004
+#define PCI_BAR_IS_IO               0x00000001
+#define PCI_BAR_IO_ADDRESS_MASK     0xFFFFFFFC
+
+#define PCI_CLASS_MASS_STORAGE      0x01
+#define PCI_SUBCLASS_IDE            0x01
+
+struct pci_device
+{
+    uint8_t bus;
+    uint8_t device;
+    uint8_t function;
+    uint16_t vendor_id;
+    uint16_t device_id;
+    uint8_t class_code;
+    uint8_t subclass;
+    uint8_t prog_if;     // Programming interface, what the class means by it.
+};
+
+uint32_t pci_config_read(struct pci_device *device, uint8_t offset);
+
+void pci_config_write(struct pci_device *device, uint8_t offset, uint32_t val);
+
+// Find the first function of the class and subclass on any bus.
+int pci_find_device(uint8_t class_code, uint8_t subclass, struct pci_device *device);
+
+// Base address register `index`, with the type bits still in it.
+uint32_t pci_get_bar(struct pci_device *device, int index);
+
+// Set bits of the command register, e.g. to let the device master the bus.
+void pci_enable_command(struct pci_device *device, uint16_t bits);
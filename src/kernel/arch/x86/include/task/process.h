@@ -1,19 +1,70 @@
 #pragma once
 #include <types.h>
 #include <fs/path_parser.h>
+#include <task/region.h>
+
+// Protection and flags of mmap, with the values of Linux.
+#define PROT_READ 0x1
+#define PROT_WRITE 0x2
+#define MAP_SHARED 0x01
+#define MAP_PRIVATE 0x02
+#define MAP_FIXED 0x10
+#define MAP_ANONYMOUS 0x20
 
-#define MAX_PROGRAM_ALLOCATIONS 1024
 #define MAX_PROCESSES 20
+#define MAX_PROCESS_FILES 16
 struct process
 {
     uint16_t id;
 
     char binary_file[FILESYSTEM_MAX_PATH_LENGTH];      // Filename of binary file.
     struct task *task;                                 // Main process task.
-    void *memory_allocations[MAX_PROGRAM_ALLOCATIONS]; // The memory allocations (malloc) of the process.
-    void *physical_pointer;                            // Physical memory pointer to the process memory.
-    uint32_t size;                                     // The size of the data pointed by `physical_pointer`.
-    void *stack_pointer;                               // Physical memory pointer to the stack memory.
+    int fd;                                            // Binary file, kept open to load pages on demand.
+    uint32_t size;                                     // The size of the binary file.
+    struct process_region *regions;                    // Memory regions of the user window, sorted.
+    struct process_region *region_tree;                // The same regions, as a tree to look them up.
+    uint32_t heap_start;                               // The heap starts right after the binary.
+    uint32_t brk;                                      // End of the heap, moved by brk and sbrk.
+    int files[MAX_PROCESS_FILES];                      // VFS descriptors the process opened, 0 is a free slot.
+};
+
+struct process_mmap_args
+{ // Arguments of the mmap syscall, in the order of the Linux i386 `old_mmap`.
+    uint32_t addr;
+    uint32_t length;
+    uint32_t prot;
+    uint32_t flags;
+    int fd; // A descriptor of the process, not of the VFS.
+    uint32_t offset;
 };
 
-int load_process(const char *filename, struct process **process);
\ No newline at end of file
+int load_process(const char *filename, struct process **process);
+
+// Release everything the process holds, its slot is free again.
+void process_terminate(struct process *process);
+
+// Duplicate `parent` into a free slot, return the id of the child.
+int process_fork(struct process *parent, struct process **child);
+
+// Open a file for `process`, return the descriptor the process uses for it.
+int process_open(struct process *process, const char *filename, const char *mode);
+
+// Close a descriptor of `process`, -EBADF if the process does not own it.
+int process_close(struct process *process, int fd);
+
+// Map an open file, or zeroed memory with MAP_ANONYMOUS, into the user
+// window of `process`, pages are only filled when they are touched.
+// Return the address of the mapping or an ERR_PTR.
+void *process_mmap(struct process *process, struct process_mmap_args *args);
+
+int process_munmap(struct process *process, void *address, uint32_t length);
+
+// Move the end of the heap to `address`, return the end of the heap,
+// which is unchanged if it could not move.
+void *process_brk(struct process *process, void *address);
+
+// Move the end of the heap by `increment`, return the previous end or an ERR_PTR.
+void *process_sbrk(struct process *process, int increment);
+
+// Resolve a page fault of the current process, 0 if it can resume.
+int process_handle_page_fault(uint32_t address, uint32_t error_code);
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+#include <types.h>
+
+// A process does not get its memory when it is loaded. Its user window is
+// described by regions instead, and the pages of a region are only
+// allocated when they are touched for the first time, by the page fault
+// handler. Anonymous regions (stack, heap, bss) get zeroed pages, file
+// regions get the pages of the page cache, shared with every process that
+// maps the same file. A write to a writeable file region copies the page.
+#define PROCESS_REGION_ANONYMOUS        0x00
+#define PROCESS_REGION_FILE             0x01
+
+#define PROCESS_REGION_WRITEABLE        0x01
+#define PROCESS_REGION_GROWS_DOWN       0x02 // Stack, faults right below it extend it.
+
+// Mappings without a fixed address are placed from here up, the program
+// and its heap live below.
+#define PROCESS_REGION_MMAP_START       0x60000000
+
+// Error code pushed by the CPU for a page fault.
+#define PAGE_FAULT_PRESENT              0x01 // Protection violation on a present page.
+#define PAGE_FAULT_WRITE                0x02 // Fault caused by a write.
+#define PAGE_FAULT_USER                 0x04 // Fault happened in user mode.
+
+struct process_region
+{
+    uint32_t start;        // Page aligned, first address of the region.
+    uint32_t end;          // Page aligned, first address after the region.
+    uint8_t type;
+    uint8_t flags;
+    int fd;                // File of a file region, the region holds a reference to it.
+    uint32_t file_offset;  // Offset in the file of `start`.
+    uint32_t file_size;    // Bytes of the file in the region, the rest reads as zeros.
+    struct process_region *next; // Regions are listed by address, for walking them in order.
+    struct process_region *prev;
+    struct process_region *left;  // AVL tree by address, for lookups.
+    struct process_region *right;
+    int height;
+};
+
+struct process;
+
+struct process_region *process_region_add(struct process *process,
+                                          uint32_t start,
+                                          uint32_t end,
+                                          uint8_t type,
+                                          uint8_t flags);
+
+// Back a file region with `size` bytes of the file `fd` from `offset`.
+int process_region_set_file(struct process_region *region, int fd, uint32_t offset, uint32_t size);
+
+struct process_region *process_region_find(struct process *process, uint32_t address);
+
+// Lowest free range of `size` bytes above `PROCESS_REGION_MMAP_START`, 0 if there is none.
+uint32_t process_region_find_free(struct process *process, uint32_t size);
+
+// Move the end of the region, pages past a lower end are given back.
+int process_region_grow(struct process *process, struct process_region *region, uint32_t end);
+
+// Drop every page of [start, end), regions partly in the range are cut.
+int process_region_unmap(struct process *process, uint32_t start, uint32_t end);
+
+// Unlink the region and give back its pages.
+void process_region_remove(struct process *process, struct process_region *region);
+
+void process_region_release_all(struct process *process);
+
+// Give `child` the regions of `parent`. Pages already touched are shared,
+// writeable ones become read only in both and are copied on write.
+int process_region_clone_all(struct process *parent, struct process *child);
+
+// Resolve a page fault of `process`, 0 if the faulting page is now mapped.
+int process_region_handle_fault(struct process *process, uint32_t address, uint32_t error_code);
@@ -1,9 +1,13 @@
 #pragma once
 #include <types.h>
+#include <memory/paging.h>
 
-#define PROGRAM_VIRTUAL_ADDRESS 0x400000
+#define PROGRAM_VIRTUAL_ADDRESS USER_SPACE_START
 #define USER_PROGRAM_STACK_SIZE 1024 * 16
-#define PROGRAM_VIRTUAL_STACK_ADDRESS_START 0x3FF000
+// The stack grows on page faults up to this size, below it is a guard page
+// that is never mapped, so an overflow faults.
+#define USER_PROGRAM_STACK_MAX_SIZE (8 * 1024 * 1024)
+#define PROGRAM_VIRTUAL_STACK_ADDRESS_START USER_SPACE_END
 #define PROGRAM_VIRTUAL_STACK_ADDRESS_END (PROGRAM_VIRTUAL_STACK_ADDRESS_START - USER_PROGRAM_STACK_SIZE)
 
 #define USER_DATA_SEGMENT 0x23
@@ -53,4 +57,18 @@ int load_user_task_page();
 
 void task_save_state(struct task *task, struct interrupt_frame *frame);
 
-int copy_from_user(struct task *task, void *user_ptr, void *to, int size);
\ No newline at end of file
+// Idle loop of the kernel, where it goes when no task can run. Never returns.
+void kernel_idle();
+
+// Leave the interrupt of a terminated task for the idle loop, on a stack the
+// next interrupt of a task does not overwrite. Never returns.
+void task_exit_to_kernel();
+
+// Copy between the kernel and the user window of `task`, pages the task
+// has not touched yet are faulted in. 0, or -EFAULT for a bad user range.
+int copy_from_user(struct task *task, void *user_ptr, void *to, size_t size);
+int copy_to_user(struct task *task, void *from, void *user_ptr, size_t size);
+
+// Copy a string of at most `max` bytes including the terminator, return
+// its length. A longer string is cut and terminated.
+int strncpy_from_user(struct task *task, void *user_ptr, char *to, size_t max);
\ No newline at end of file
@@ -0,0 +1,28 @@
+#pragma once
+#include <types.h>
+#include <stdbool.h>
+
+// Tasks waiting for an event, usually an interrupt. There is no scheduler
+// to hand the CPU to yet, so a waiting task halts the CPU until the next
+// interrupt and checks again, instead of spinning on device registers.
+struct task;
+struct wait_queue_entry
+{
+    struct task *task;             // Task that waits, NULL during boot.
+    volatile bool woken;           // Set by `wait_queue_wake_all()`, from interrupt context.
+    struct wait_queue_entry *next;
+};
+
+struct wait_queue
+{
+    struct wait_queue_entry *head;
+};
+
+void wait_queue_init(struct wait_queue *queue);
+
+// Sleep until the queue is woken, through at most `max_interrupts`
+// interrupts. Called with interrupts disabled, they are disabled again on
+// return. 0, or -ETIMEDOUT.
+int wait_queue_wait(struct wait_queue *queue, int max_interrupts);
+
+void wait_queue_wake_all(struct wait_queue *queue);
@@ -5,7 +5,12 @@ global load_interrupt_descriptor_table
 global enable_interrupts
 global disable_interrupts
 global no_interrupt
+global page_fault_wrapper
+global disk_interrupt_wrapper
+global wait_for_interrupt
 extern no_interrupt_handler
+extern page_fault_handler
+extern disk_interrupt_handler
 
 load_interrupt_descriptor_table:
     ; Make new call frame.
@@ -28,9 +33,40 @@ disable_interrupts:
     cli
     ret
 
+; Halt until the next interrupt. `sti` only takes effect after `hlt`, so an
+; interrupt that is already pending still wakes us up, it can not slip in
+; between the caller's last check and the halt.
+wait_for_interrupt:
+    sti
+    hlt
+    cli
+    ret
+
 ; Interrupt wrapper.
 no_interrupt:
     pushad
     call no_interrupt_handler
     popad
-    iret
\ No newline at end of file
+    iret
+
+; Page fault wrapper, the CPU pushes an error code on top of the
+; interrupt frame and leaves the faulting address in CR2.
+page_fault_wrapper:
+    pushad
+
+    push dword [esp + 32]   ; Error code, right above the registers pushed by `pushad`.
+    mov eax, cr2
+    push eax                ; Faulting address.
+    call page_fault_handler
+    add esp, 8
+
+    popad
+    add esp, 4              ; Drop the error code, `iret` does not expect it.
+    iret
+
+; Primary ATA channel, IRQ 14.
+disk_interrupt_wrapper:
+    pushad
+    call disk_interrupt_handler
+    popad
+    iret
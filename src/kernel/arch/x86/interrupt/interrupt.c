@@ -2,6 +2,10 @@
 #include <string.h>
 #include <video.h>
 #include <io.h>
+#include <panic.h>
+#include <task/process.h>
+#include <task/region.h>
+#include <task/task.h>
 
 // Assembly functions.
 extern void load_interrupt_descriptor_table(void *ptr);
@@ -24,8 +28,37 @@ void idt_divide_by_zero()
 
 extern void no_interrupt();
 
+void page_fault_handler(uint32_t address, uint32_t error_code)
+{ // Pages of a process are mapped the first time they are touched. A fault
+  // the process can not resolve only kills the process when it happened in
+  // user mode, in the kernel it is fatal.
+    if (process_handle_page_fault(address, error_code) == 0)
+    {
+        return;
+    }
+
+    print("Page fault at address: ");
+    print_number(address);
+    print(", error code: ");
+    print_number(error_code);
+    print(".\n");
+    struct task *task = get_current_task();
+    if (!(error_code & PAGE_FAULT_USER) || task == NULL || task->proc == NULL)
+    {
+        arc_panic("Unresolvable page fault.");
+    }
+
+    // Never go back to the task, the kernel carries on in its idle loop.
+    load_kernel_data_segment_registers();
+    print("Killed the faulting process.\n");
+    process_terminate(task->proc);
+    task_exit_to_kernel();
+}
+
 void no_interrupt_handler()
-{
+{ // Unhandled IRQs of the slave PIC have to be ended there too, an EOI
+  // with nothing in service is ignored.
+    outb(0xA0, 0x20);
     outb(0x20, 0x20);
 }
 
@@ -36,8 +69,8 @@ void init_pic(void)
     outb(0xA0, 0x11);
 
     /* Initialization of ICW2 */
-    outb(0x21, 0x20); /* start vector = 32 */
-    outb(0xA1, 0x70); /* start vector = 96 */
+    outb(0x21, PIC_MASTER_VECTOR_OFFSET); /* start vector = 32 */
+    outb(0xA1, PIC_SLAVE_VECTOR_OFFSET);  /* start vector = 112 */
 
     /* Initialization of ICW3 */
     outb(0x21, 0x04);
@@ -78,9 +111,12 @@ void init_interrupt_descriptor_table()
     }
 
     set_interrupt_handler(DIVIDE_BY_ZERO_INTERRUPT_NUMBER, &idt_divide_by_zero);
+    set_interrupt_handler(PAGE_FAULT_INTERRUPT_NUMBER, &page_fault_wrapper);
     set_interrupt_handler(SYSTEM_CALL_INTERRUPT_NUMBER, &syscall_wrapper);
+    set_interrupt_handler(DISK_INTERRUPT_NUMBER, &disk_interrupt_wrapper);
 
     load_interrupt_descriptor_table((void *)&idt_register);
+    init_pic();
 }
 
 void enable_interrupt()
@@ -4,6 +4,12 @@ global inb
 global inw
 global outb
 global outw
+global inl
+global outl
+global insw
+global outsw
+global insl
+global outsl
 
 ; Basic I/O Functions.
 inb:
@@ -50,4 +56,86 @@ outw:
     out dx, ax
 
     pop ebp
-    ret
\ No newline at end of file
+    ret
+inl:
+    push ebp
+    mov ebp, esp
+
+    mov edx, [ebp+8]
+    in eax, dx
+
+    pop ebp
+    ret
+
+outl:
+    push ebp
+    mov ebp, esp
+
+    mov eax, [ebp+12]
+    mov edx, [ebp+8]
+    out dx, eax
+
+    pop ebp
+    ret
+
+; String I/O, `count` words (or double words) between the port and memory
+; with a single `rep` instruction, instead of one call per word.
+insw:
+    push ebp
+    mov ebp, esp
+    push edi                ; EDI belongs to the caller.
+
+    mov edx, [ebp+8]        ; Port.
+    mov edi, [ebp+12]       ; Buffer.
+    mov ecx, [ebp+16]       ; Count.
+    cld
+    rep insw
+
+    pop edi
+    pop ebp
+    ret
+
+outsw:
+    push ebp
+    mov ebp, esp
+    push esi                ; ESI belongs to the caller.
+
+    mov edx, [ebp+8]
+    mov esi, [ebp+12]
+    mov ecx, [ebp+16]
+    cld
+    rep outsw
+
+    pop esi
+    pop ebp
+    ret
+
+insl:
+    push ebp
+    mov ebp, esp
+    push edi
+
+    mov edx, [ebp+8]
+    mov edi, [ebp+12]
+    mov ecx, [ebp+16]
+    cld
+    rep insd
+
+    pop edi
+    pop ebp
+    ret
+
+outsl:
+    push ebp
+    mov ebp, esp
+    push esi
+
+    mov edx, [ebp+8]
+    mov esi, [ebp+12]
+    mov ecx, [ebp+16]
+    cld
+    rep outsd
+
+    pop esi
+    pop ebp
+    ret
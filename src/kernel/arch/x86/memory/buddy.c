@@ -0,0 +1,291 @@
+#include <memory/buddy.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <string.h>
+
+static bool buddy_validate_alignment(void *ptr)
+{
+    return ((uint32_t)ptr % BUDDY_BLOCK_SIZE_BYTES) == 0;
+}
+
+static void *buddy_get_block_address(struct buddy_heap *heap, size_t num)
+{
+    return heap->start_address + (num * BUDDY_BLOCK_SIZE_BYTES);
+}
+
+static size_t buddy_get_block_number(struct buddy_heap *heap, void *address)
+{
+    return (size_t)(address - heap->start_address) / BUDDY_BLOCK_SIZE_BYTES;
+}
+
+static int buddy_get_order_of_blocks(size_t total_blocks)
+{ // Smallest order which run holds `total_blocks` blocks.
+    int order = 0;
+    while (((size_t)1 << order) < total_blocks)
+    {
+        order++;
+    }
+
+    return order;
+}
+
+static void buddy_push_free_block(struct buddy_heap *heap, size_t num, int order)
+{
+    struct buddy_free_block *block = buddy_get_block_address(heap, num);
+    block->prev = NULL;
+    block->next = heap->free_lists[order];
+    if (block->next != NULL)
+    {
+        block->next->prev = block;
+    }
+
+    heap->free_lists[order] = block;
+    heap->free_orders |= (1U << order);
+    heap->entries[num] = BUDDY_BLOCK_IS_HEAD | BUDDY_BLOCK_IS_FREE | order;
+}
+
+static void buddy_remove_free_block(struct buddy_heap *heap, size_t num, int order)
+{
+    struct buddy_free_block *block = buddy_get_block_address(heap, num);
+    if (block->prev != NULL)
+    {
+        block->prev->next = block->next;
+    }
+    else
+    {
+        heap->free_lists[order] = block->next;
+    }
+
+    if (block->next != NULL)
+    {
+        block->next->prev = block->prev;
+    }
+
+    if (heap->free_lists[order] == NULL)
+    {
+        heap->free_orders &= ~(1U << order);
+    }
+
+    heap->entries[num] = 0;
+}
+
+int buddy_create(struct buddy_heap *heap, void *start, void *end, buddy_block_entry *entries)
+{
+    int res = 0;
+    if (!buddy_validate_alignment(start) || !buddy_validate_alignment(end) || end < start)
+    {
+        res = -EINVAL;
+        goto out;
+    }
+
+    memset(heap, 0, sizeof(struct buddy_heap));
+    heap->start_address = start;
+    heap->total_blocks = (size_t)(end - start) / BUDDY_BLOCK_SIZE_BYTES;
+    heap->entries = entries;
+    memset(entries, 0, heap->total_blocks * sizeof(buddy_block_entry));
+
+    // The heap size does not have to be a power of two, cut it into the
+    // largest runs that are aligned on their own size and still fit.
+    size_t num = 0;
+    while (num < heap->total_blocks)
+    {
+        int order = BUDDY_MAX_ORDER;
+        while (order > 0 && ((num & ((1U << order) - 1)) || (num + (1U << order)) > heap->total_blocks))
+        {
+            order--;
+        }
+
+        buddy_push_free_block(heap, num, order);
+        num += (1U << order);
+    }
+
+out:
+    return res;
+}
+
+void *buddy_malloc(struct buddy_heap *heap, size_t size)
+{
+    void *address = NULL;
+    size_t total_blocks = (size + BUDDY_BLOCK_SIZE_BYTES - 1) / BUDDY_BLOCK_SIZE_BYTES;
+    if (total_blocks == 0)
+    {
+        goto out;
+    }
+
+    int order = buddy_get_order_of_blocks(total_blocks);
+    if (order > BUDDY_MAX_ORDER)
+    {
+        goto out;
+    }
+
+    // Smallest order with a free run that is large enough.
+    uint32_t candidate_orders = heap->free_orders & ~((1U << order) - 1);
+    if (candidate_orders == 0)
+    {
+        goto out;
+    }
+
+    int current_order = __builtin_ctz(candidate_orders);
+    size_t num = buddy_get_block_number(heap, heap->free_lists[current_order]);
+    buddy_remove_free_block(heap, num, current_order);
+
+    // Split the run in halves until it has the requested order,
+    // the upper half of each split goes back to the free lists.
+    while (current_order > order)
+    {
+        current_order--;
+        buddy_push_free_block(heap, num + (1U << current_order), current_order);
+    }
+
+    heap->entries[num] = BUDDY_BLOCK_IS_HEAD | order;
+    address = buddy_get_block_address(heap, num);
+
+out:
+    return address;
+}
+
+static int buddy_get_allocation_start(struct buddy_heap *heap, void *ptr)
+{ // Block number of `ptr` if it is the start of an allocation.
+    if (ptr < heap->start_address || !buddy_validate_alignment(ptr))
+    {
+        return -EINVAL;
+    }
+
+    size_t num = buddy_get_block_number(heap, ptr);
+    if (num >= heap->total_blocks)
+    {
+        return -EINVAL;
+    }
+
+    buddy_block_entry entry = heap->entries[num];
+    if (!(entry & BUDDY_BLOCK_IS_HEAD) || (entry & BUDDY_BLOCK_IS_FREE))
+    { // Not the start of an allocation.
+        return -EINVAL;
+    }
+
+    return num;
+}
+
+void buddy_free(struct buddy_heap *heap, void *ptr)
+{
+    int res = buddy_get_allocation_start(heap, ptr);
+    if (res < 0)
+    {
+        return;
+    }
+
+    // Merge with the buddy as long as the buddy is a free run of the same order.
+    size_t num = res;
+    int order = heap->entries[num] & BUDDY_BLOCK_ORDER_MASK;
+    while (order < BUDDY_MAX_ORDER)
+    {
+        size_t buddy = num ^ (1U << order);
+        if (buddy + (1U << order) > heap->total_blocks ||
+            heap->entries[buddy] != (BUDDY_BLOCK_IS_HEAD | BUDDY_BLOCK_IS_FREE | order))
+        {
+            break;
+        }
+
+        buddy_remove_free_block(heap, buddy, order);
+        heap->entries[num] = 0;
+        num = (num < buddy) ? num : buddy;
+        order++;
+    }
+
+    buddy_push_free_block(heap, num, order);
+}
+
+void *buddy_realloc(struct buddy_heap *heap, void *ptr, size_t size)
+{
+    void *address = NULL;
+    int res = buddy_get_allocation_start(heap, ptr);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    size_t total_blocks = (size + BUDDY_BLOCK_SIZE_BYTES - 1) / BUDDY_BLOCK_SIZE_BYTES;
+    if (total_blocks == 0)
+    {
+        buddy_free(heap, ptr);
+        goto out;
+    }
+
+    size_t num = res;
+    int order = heap->entries[num] & BUDDY_BLOCK_ORDER_MASK;
+    int new_order = buddy_get_order_of_blocks(total_blocks);
+    if (new_order > BUDDY_MAX_ORDER)
+    {
+        goto out;
+    }
+
+    // Shrink by giving the upper halves back. Their buddies are the lower
+    // halves that stay allocated, so there is nothing to merge.
+    while (order > new_order)
+    {
+        order--;
+        buddy_push_free_block(heap, num + (1U << order), order);
+    }
+
+    // Grow by doubling as long as the run is the lower half of its parent
+    // and the upper half is a free run of the same order.
+    int grown_order = order;
+    while (grown_order < new_order)
+    {
+        size_t buddy = num ^ (1U << grown_order);
+        if (buddy < num ||
+            buddy + (1U << grown_order) > heap->total_blocks ||
+            heap->entries[buddy] != (BUDDY_BLOCK_IS_HEAD | BUDDY_BLOCK_IS_FREE | grown_order))
+        {
+            break;
+        }
+
+        grown_order++;
+    }
+
+    if (grown_order == new_order)
+    {
+        for (int i = order; i < new_order; i++)
+        {
+            buddy_remove_free_block(heap, num + (1U << i), i);
+        }
+
+        heap->entries[num] = BUDDY_BLOCK_IS_HEAD | new_order;
+        address = ptr;
+        goto out;
+    }
+
+    heap->entries[num] = BUDDY_BLOCK_IS_HEAD | order;
+    address = buddy_malloc(heap, size);
+    if (address == NULL)
+    {
+        goto out;
+    }
+
+    memcpy(address, ptr, (1U << order) * BUDDY_BLOCK_SIZE_BYTES);
+    buddy_free(heap, ptr);
+
+out:
+    return address;
+}
+
+size_t buddy_get_allocation_size(struct buddy_heap *heap, void *ptr)
+{
+    int num = buddy_get_allocation_start(heap, ptr);
+    if (num < 0)
+    {
+        return 0;
+    }
+
+    return (1U << (heap->entries[num] & BUDDY_BLOCK_ORDER_MASK)) * BUDDY_BLOCK_SIZE_BYTES;
+}
+
+size_t buddy_get_largest_free_block(struct buddy_heap *heap)
+{
+    if (heap->free_orders == 0)
+    {
+        return 0;
+    }
+
+    return (1U << (31 - __builtin_clz(heap->free_orders))) * BUDDY_BLOCK_SIZE_BYTES;
+}
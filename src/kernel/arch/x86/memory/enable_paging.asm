@@ -3,6 +3,11 @@ section .asm
 
 global enable_paging
 global paging_load_directory
+global paging_enable_large_pages
+global paging_invalidate_page
+global paging_flush_tlb
+global paging_flush_global_tlb
+global paging_enable_global_pages
 
 ; Enabling paging is actually very simple. All that is needed is to load CR3
 ; with the address of the page directory and to set the paging (PG) and protection 
@@ -18,12 +23,97 @@ paging_load_directory:
     pop ebp
     ret
 
+; Drop the TLB entry of the page holding the address, other translations stay.
+paging_invalidate_page:
+    push ebp
+    mov ebp, esp
+
+    mov eax, [ebp+8]
+    invlpg [eax]
+
+    pop ebp
+    ret
+
+; Writing CR3 back drops every TLB entry that is not global.
+paging_flush_tlb:
+    push ebp
+    mov ebp, esp
+
+    mov eax, cr3
+    mov cr3, eax
+
+    pop ebp
+    ret
+
+; Global pages survive CR3 writes, toggling CR4.PGE is what drops them too.
+; The original CR4 is restored, so this also works with PGE off.
+paging_flush_global_tlb:
+    push ebp
+    mov ebp, esp
+
+    mov eax, cr4
+    mov ecx, eax
+    and ecx, ~(1 << 7)
+    mov cr4, ecx
+    mov ecx, cr3
+    mov cr3, ecx
+    mov cr4, eax
+
+    pop ebp
+    ret
+
 enable_paging:
     push ebp
     mov ebp, esp
 
-    or eax, 0x80000000
+    mov eax, cr0
+    or eax, 0x80010000  ; PG, and WP so the kernel also faults on copy on write pages.
     mov cr0, eax
 
     pop ebp
-    ret
\ No newline at end of file
+    ret
+; 4 MiB pages (PSE) are reported by CPUID leaf 1 in EDX bit 3 and turned on
+; with CR4 bit 4. Returns 1 if they were enabled, 0 if the CPU lacks them.
+paging_enable_large_pages:
+    push ebp
+    mov ebp, esp
+    push ebx            ; CPUID clobbers EBX, it belongs to the caller.
+
+    mov eax, 1
+    cpuid
+    xor eax, eax
+    test edx, 1 << 3
+    jz .out
+
+    mov eax, cr4
+    or eax, 1 << 4
+    mov cr4, eax
+    mov eax, 1
+
+.out:
+    pop ebx
+    pop ebp
+    ret
+
+; Global pages (PGE) are reported by CPUID leaf 1 in EDX bit 13 and turned on
+; with CR4 bit 7. Returns 1 if they were enabled, 0 if the CPU lacks them.
+paging_enable_global_pages:
+    push ebp
+    mov ebp, esp
+    push ebx
+
+    mov eax, 1
+    cpuid
+    xor eax, eax
+    test edx, 1 << 13
+    jz .out
+
+    mov eax, cr4
+    or eax, 1 << 7
+    mov cr4, eax
+    mov eax, 1
+
+.out:
+    pop ebx
+    pop ebp
+    ret
@@ -0,0 +1,358 @@
+#include <memory/frame.h>
+#include <memory/paging.h>
+#include <stdbool.h>
+#include <string.h>
+#include <video.h>
+#include <errno.h>
+
+#define FRAME_SHIFT 12
+#define FRAME_ADDRESS_LIMIT ((uint64_t)USER_SPACE_START) // Frames have to be reachable in every address space.
+
+static struct frame_allocator frames;
+
+static uint64_t frame_align_up(uint64_t address)
+{
+    return (address + FRAME_SIZE_BYTES - 1) & ~((uint64_t)FRAME_SIZE_BYTES - 1);
+}
+
+static uint64_t frame_align_down(uint64_t address)
+{
+    return address & ~((uint64_t)FRAME_SIZE_BYTES - 1);
+}
+
+static uint64_t frame_get_entry_end(struct e820_entry *entry)
+{
+    uint64_t end = entry->base + entry->length;
+    return (end > FRAME_ADDRESS_LIMIT) ? FRAME_ADDRESS_LIMIT : end;
+}
+
+static void frame_mark_range(size_t first_frame, size_t total, bool used)
+{ // Set or clear `total` bits from `first_frame`, a word at a time when possible.
+    while (total > 0)
+    {
+        size_t bit = first_frame % 32;
+        size_t bits = 32 - bit;
+        if (bits > total)
+        {
+            bits = total;
+        }
+
+        uint32_t mask = (bits == 32) ? 0xFFFFFFFF : (((1U << bits) - 1) << bit);
+        if (used)
+        {
+            frames.bitmap[first_frame / 32] |= mask;
+        }
+        else
+        {
+            frames.bitmap[first_frame / 32] &= ~mask;
+        }
+
+        first_frame += bits;
+        total -= bits;
+    }
+}
+
+static void frame_mark_entry(struct e820_entry *entry, bool used)
+{ // Usable ranges shrink to whole frames, reserved ranges grow to whole frames.
+    uint64_t start = used ? frame_align_down(entry->base) : frame_align_up(entry->base);
+    uint64_t end = used ? frame_align_up(frame_get_entry_end(entry)) : frame_align_down(frame_get_entry_end(entry));
+    if (!used && start < FRAME_ALLOCATOR_START_ADDRESS)
+    {
+        start = FRAME_ALLOCATOR_START_ADDRESS;
+    }
+
+    uint64_t limit = (uint64_t)frames.total_frames << FRAME_SHIFT;
+    if (end > limit)
+    {
+        end = limit;
+    }
+
+    if (start >= end)
+    {
+        return;
+    }
+
+    frame_mark_range(start >> FRAME_SHIFT, (end - start) >> FRAME_SHIFT, used);
+}
+
+static bool frame_is_used(size_t frame)
+{
+    return frames.bitmap[frame / 32] & (1U << (frame % 32));
+}
+
+static size_t frame_count_free()
+{
+    size_t total = 0;
+    for (size_t i = 0; i < (frames.total_frames + 31) / 32; i++)
+    {
+        uint32_t word = ~frames.bitmap[i];
+        while (word)
+        { // Clear the lowest set bit.
+            word &= word - 1;
+            total++;
+        }
+    }
+
+    return total;
+}
+
+void frame_allocator_init()
+{
+    struct e820_entry fallback_entry = {
+        .base = FRAME_ALLOCATOR_START_ADDRESS,
+        .length = FRAME_ALLOCATOR_FALLBACK_END - FRAME_ALLOCATOR_START_ADDRESS,
+        .type = E820_MEMORY_TYPE_USABLE,
+        .acpi_attributes = 1};
+
+    struct e820_entry *entries = (struct e820_entry *)E820_MAP_ENTRIES_ADDRESS;
+    uint32_t total_entries = *(uint32_t *)E820_MAP_COUNT_ADDRESS;
+    if (total_entries == 0 || total_entries > E820_MAX_ENTRIES)
+    {
+        print("No BIOS memory map, assuming the default memory size.\n");
+        entries = &fallback_entry;
+        total_entries = 1;
+    }
+
+    memset(&frames, 0, sizeof(frames));
+
+    // The bitmap covers every frame up to the end of the highest usable range.
+    uint64_t memory_end = 0;
+    for (int i = 0; i < total_entries; i++)
+    {
+        if (entries[i].type == E820_MEMORY_TYPE_USABLE && frame_get_entry_end(&entries[i]) > memory_end)
+        {
+            memory_end = frame_get_entry_end(&entries[i]);
+        }
+    }
+
+    size_t total_frames = memory_end >> FRAME_SHIFT;
+    size_t bitmap_size = ((total_frames + 31) / 32) * sizeof(uint32_t);
+    size_t metadata_size = bitmap_size + (total_frames * sizeof(frame_refcount));
+
+    // Keep the bitmap and the reference counts in the first usable range
+    // above the kernel that can hold them.
+    for (int i = 0; i < total_entries; i++)
+    {
+        uint64_t start = frame_align_up(entries[i].base);
+        uint64_t end = frame_align_down(frame_get_entry_end(&entries[i]));
+        if (start < FRAME_ALLOCATOR_START_ADDRESS)
+        {
+            start = FRAME_ALLOCATOR_START_ADDRESS;
+        }
+
+        if (entries[i].type == E820_MEMORY_TYPE_USABLE && end > start && (end - start) >= metadata_size)
+        {
+            frames.bitmap = (uint32_t *)(uint32_t)start;
+            break;
+        }
+    }
+
+    if (frames.bitmap == NULL)
+    {
+        print("Failed to find memory for the page frame allocator.\n");
+        return;
+    }
+
+    // Everything is in use until the memory map says otherwise. Usable ranges
+    // go first, so reserved ranges overlapping them win.
+    frames.total_frames = total_frames;
+    memset(frames.bitmap, 0xFF, bitmap_size);
+    frames.refcounts = (frame_refcount *)((uint32_t)frames.bitmap + bitmap_size);
+    memset(frames.refcounts, 0, total_frames * sizeof(frame_refcount));
+    for (int i = 0; i < total_entries; i++)
+    {
+        if (entries[i].type == E820_MEMORY_TYPE_USABLE)
+        {
+            frame_mark_entry(&entries[i], false);
+        }
+    }
+
+    for (int i = 0; i < total_entries; i++)
+    {
+        if (entries[i].type != E820_MEMORY_TYPE_USABLE)
+        {
+            frame_mark_entry(&entries[i], true);
+        }
+    }
+
+    frame_mark_range((uint32_t)frames.bitmap >> FRAME_SHIFT,
+                     (metadata_size + FRAME_SIZE_BYTES - 1) >> FRAME_SHIFT,
+                     true);
+
+    frames.free_frames = frame_count_free();
+    frames.next_free_word = 0;
+
+    print("Physical memory: ");
+    print_number(frames.free_frames * (FRAME_SIZE_BYTES / 1024));
+    print(" KiB free for page frames.\n");
+}
+
+void *frame_alloc()
+{
+    size_t total_words = (frames.total_frames + 31) / 32;
+    for (size_t i = 0; i < total_words; i++)
+    {
+        size_t word = (frames.next_free_word + i) % total_words;
+        if (frames.bitmap[word] == 0xFFFFFFFF)
+        {
+            continue;
+        }
+
+        // Bits past the last frame are always set, any clear bit is a real frame.
+        size_t frame = (word * 32) + __builtin_ctz(~frames.bitmap[word]);
+        frames.bitmap[word] |= (1U << (frame % 32));
+        frames.refcounts[frame] = 1;
+        frames.free_frames--;
+        frames.next_free_word = word;
+        return (void *)(frame << FRAME_SHIFT);
+    }
+
+    // Out of plain frames, the zeroed ones are still good.
+    if (frames.total_zeroed > 0)
+    {
+        return frames.zeroed_pool[--frames.total_zeroed];
+    }
+
+    return NULL;
+}
+
+void *frame_alloc_contiguous(size_t total_frames)
+{ // First fit, this is only meant for large boot time reservations.
+    size_t run_start = 0;
+    size_t run_length = 0;
+    if (total_frames == 0)
+    {
+        return NULL;
+    }
+
+    for (size_t frame = FRAME_ALLOCATOR_START_ADDRESS >> FRAME_SHIFT; frame < frames.total_frames; frame++)
+    {
+        if (frame_is_used(frame))
+        {
+            run_length = 0;
+            continue;
+        }
+
+        if (run_length == 0)
+        {
+            run_start = frame;
+        }
+
+        run_length++;
+        if (run_length == total_frames)
+        {
+            frame_mark_range(run_start, total_frames, true);
+            memset(&frames.refcounts[run_start], 1, total_frames * sizeof(frame_refcount));
+            frames.free_frames -= total_frames;
+            return (void *)(run_start << FRAME_SHIFT);
+        }
+    }
+
+    return NULL;
+}
+
+static int frame_get_allocated_number(void *frame)
+{ // Frame number of an allocated frame, -EINVAL for anything else.
+    size_t num = (uint32_t)frame >> FRAME_SHIFT;
+    if (((uint32_t)frame % FRAME_SIZE_BYTES) ||
+        (uint32_t)frame < FRAME_ALLOCATOR_START_ADDRESS ||
+        num >= frames.total_frames ||
+        frames.refcounts[num] == 0)
+    {
+        return -EINVAL;
+    }
+
+    return num;
+}
+
+void frame_free(void *frame)
+{
+    int num = frame_get_allocated_number(frame);
+    if (num < 0)
+    {
+        return;
+    }
+
+    // Shared frames are only released by their last user.
+    if (frames.refcounts[num] > 1)
+    {
+        frames.refcounts[num]--;
+        return;
+    }
+
+    frames.refcounts[num] = 0;
+    frames.bitmap[num / 32] &= ~(1U << (num % 32));
+    frames.free_frames++;
+    if (num / 32 < frames.next_free_word)
+    {
+        frames.next_free_word = num / 32;
+    }
+}
+
+int frame_ref(void *frame)
+{
+    int num = frame_get_allocated_number(frame);
+    if (num < 0)
+    {
+        return num;
+    }
+
+    if (frames.refcounts[num] == FRAME_MAX_REFCOUNT)
+    {
+        return -ENOMEM;
+    }
+
+    frames.refcounts[num]++;
+    return 0;
+}
+
+int frame_get_refcount(void *frame)
+{
+    int num = frame_get_allocated_number(frame);
+    return (num < 0) ? 0 : frames.refcounts[num];
+}
+
+void *frame_alloc_zeroed()
+{
+    if (frames.total_zeroed > 0)
+    {
+        return frames.zeroed_pool[--frames.total_zeroed];
+    }
+
+    void *frame = frame_alloc();
+    if (frame != NULL)
+    {
+        memset(frame, 0, FRAME_SIZE_BYTES);
+    }
+
+    return frame;
+}
+
+int frame_refill_zeroed_pool(size_t max_frames)
+{
+    int total = 0;
+    while (total < max_frames && frames.total_zeroed < FRAME_ZEROED_POOL_SIZE && frames.free_frames > 0)
+    {
+        void *frame = frame_alloc();
+        if (frame == NULL)
+        {
+            break;
+        }
+
+        memset(frame, 0, FRAME_SIZE_BYTES);
+        frames.zeroed_pool[frames.total_zeroed++] = frame;
+        total++;
+    }
+
+    return total;
+}
+
+size_t frame_get_total_free()
+{ // Zeroed frames are free, they are only cleared already.
+    return frames.free_frames + frames.total_zeroed;
+}
+
+size_t frame_get_total()
+{
+    return frames.total_frames;
+}
@@ -55,6 +55,259 @@ static bool block_has_next_block(heap_block_table_entry entry)
     return entry & HEAP_BLOCK_HAS_NEXT;
 }
 
+static void heap_bitmap_set_range(uint32_t *bitmap, size_t start, size_t count, bool value)
+{ // Set or clear `count` bits from `start`, a whole word at a time when possible.
+    while (count > 0)
+    {
+        size_t bit = start % 32;
+        size_t bits = 32 - bit;
+        if (bits > count)
+        {
+            bits = count;
+        }
+
+        uint32_t mask = (bits == 32) ? 0xFFFFFFFF : (((1U << bits) - 1) << bit);
+        if (value)
+        {
+            bitmap[start / 32] |= mask;
+        }
+        else
+        {
+            bitmap[start / 32] &= ~mask;
+        }
+
+        start += bits;
+        count -= bits;
+    }
+}
+
+static size_t heap_bitmap_find_next_set(const uint32_t *bitmap1, const uint32_t *bitmap2, size_t from, size_t limit)
+{ // Find the first block from `from` which bit is set in either bitmap,
+  // skipping 32 clear blocks per step. Return `limit` if there is none.
+    while (from < limit)
+    {
+        size_t word = from / 32;
+        uint32_t bits = (bitmap1[word] | bitmap2[word]) & (0xFFFFFFFF << (from % 32));
+        if (bits != 0)
+        {
+            size_t found = (word * 32) + __builtin_ctz(bits);
+            return (found < limit) ? found : limit;
+        }
+
+        from = (word + 1) * 32;
+    }
+
+    return limit;
+}
+
+static int heap_bitmap_find_previous_set(const uint32_t *bitmap, int from)
+{ // Find the last block at or before `from` which bit is set, -1 if none.
+    while (from >= 0)
+    {
+        int word = from / 32;
+        uint32_t bits = bitmap[word] & (0xFFFFFFFF >> (31 - (from % 32)));
+        if (bits != 0)
+        {
+            return (word * 32) + 31 - __builtin_clz(bits);
+        }
+
+        from = (word * 32) - 1;
+    }
+
+    return -1;
+}
+
+static bool heap_table_block_is_free(struct heap_table *table, int num)
+{
+    if (table->type == HEAP_TABLE_TYPE_BITMAP)
+    {
+        return table->free_bitmap[num / 32] & (1U << (num % 32));
+    }
+
+    return block_entry_is_free(table->entries[num]);
+}
+
+static int heap_table_get_first_block(struct heap_table *table, int num)
+{ // First block of the allocation that block `num` belongs to.
+    if (table->type == HEAP_TABLE_TYPE_BITMAP)
+    {
+        int first_block_number = heap_bitmap_find_previous_set(table->first_bitmap, num);
+        return (first_block_number < 0) ? 0 : first_block_number;
+    }
+
+    int first_block_number = num;
+    while (first_block_number > 0 && !(table->entries[first_block_number] & HEAP_BLOCK_IS_FIRST))
+    {
+        first_block_number--;
+    }
+
+    return first_block_number;
+}
+
+static bool heap_table_block_is_first(struct heap_table *table, int num)
+{
+    if (table->type == HEAP_TABLE_TYPE_BITMAP)
+    {
+        return table->first_bitmap[num / 32] & (1U << (num % 32));
+    }
+
+    return table->entries[num] & HEAP_BLOCK_IS_FIRST;
+}
+
+static size_t heap_table_get_total_blocks(struct heap_table *table, int first_block_number)
+{ // Length of the allocation starting at `first_block_number`.
+    if (table->type == HEAP_TABLE_TYPE_BITMAP)
+    {
+        size_t end = heap_bitmap_find_next_set(table->free_bitmap,
+                                               table->first_bitmap,
+                                               first_block_number + 1,
+                                               table->total);
+        return end - first_block_number;
+    }
+
+    size_t total_blocks = 1;
+    for (int i = first_block_number; i < table->total - 1 && block_has_next_block(table->entries[i]); i++)
+    {
+        total_blocks++;
+    }
+
+    return total_blocks;
+}
+
+static void heap_table_extend_blocks(struct heap_table *table, int first_block_number, size_t total_blocks, size_t new_total_blocks)
+{ // Append free blocks to the end of an allocation.
+    int start = first_block_number + total_blocks;
+    int end = first_block_number + new_total_blocks;
+    if (table->type == HEAP_TABLE_TYPE_BITMAP)
+    {
+        heap_bitmap_set_range(table->free_bitmap, start, end - start, false);
+        return;
+    }
+
+    table->entries[start - 1] |= HEAP_BLOCK_HAS_NEXT;
+    for (int i = start; i < end; i++)
+    {
+        table->entries[i] = HEAP_BLOCK_TABLE_ENTRY_TAKEN;
+        if (i != end - 1)
+        {
+            table->entries[i] |= HEAP_BLOCK_HAS_NEXT;
+        }
+    }
+}
+
+static void heap_table_truncate_blocks(struct heap_table *table, int first_block_number, size_t total_blocks, size_t new_total_blocks)
+{ // Free the blocks of an allocation past its first `new_total_blocks` blocks.
+    int start = first_block_number + new_total_blocks;
+    int end = first_block_number + total_blocks;
+    if (table->type == HEAP_TABLE_TYPE_BITMAP)
+    {
+        heap_bitmap_set_range(table->free_bitmap, start, end - start, true);
+        return;
+    }
+
+    table->entries[start - 1] &= ~HEAP_BLOCK_HAS_NEXT;
+    for (int i = start; i < end; i++)
+    {
+        table->entries[i] = HEAP_BLOCK_TABLE_ENTRY_FREE;
+    }
+}
+
+static size_t heap_table_release_blocks(struct heap_table *table, int first_block_number)
+{ // Mark the allocation starting at `first_block_number` free, return its length.
+    size_t total_blocks = 0;
+    if (table->type == HEAP_TABLE_TYPE_BITMAP)
+    { // The allocation ends before the next free block or the next first block.
+        size_t end = heap_bitmap_find_next_set(table->free_bitmap,
+                                               table->first_bitmap,
+                                               first_block_number + 1,
+                                               table->total);
+        total_blocks = end - first_block_number;
+        heap_bitmap_set_range(table->first_bitmap, first_block_number, 1, false);
+        heap_bitmap_set_range(table->free_bitmap, first_block_number, total_blocks, true);
+        return total_blocks;
+    }
+
+    for (int i = first_block_number; i < table->total; i++)
+    {
+        heap_block_table_entry entry = table->entries[i];
+        table->entries[i] = HEAP_BLOCK_TABLE_ENTRY_FREE;
+        total_blocks++;
+
+        if (!(entry & HEAP_BLOCK_HAS_NEXT))
+        {
+            break;
+        }
+    }
+
+    return total_blocks;
+}
+
+static int heap_get_bucket_of_length(size_t total_blocks)
+{ // Floor of log2(total_blocks).
+    return 31 - __builtin_clz(total_blocks);
+}
+
+static void *heap_get_block_address(struct heap *heap, int num)
+{
+    return heap->start_address + (num * HEAP_BLOCK_SIZE_BYTES);
+}
+
+static size_t *heap_get_free_run_footer(struct heap *heap, int last_block_number)
+{
+    return (size_t *)(heap_get_block_address(heap, last_block_number + 1) - sizeof(size_t));
+}
+
+static void heap_insert_free_run(struct heap *heap, int start_block_number, size_t total_blocks)
+{ // Write the boundary tags of the run and push it to its bucket.
+    struct heap_free_run *run = heap_get_block_address(heap, start_block_number);
+    int bucket = heap_get_bucket_of_length(total_blocks);
+
+    run->total_blocks = total_blocks;
+    run->prev = NULL;
+    run->next = heap->free_runs[bucket];
+    if (run->next != NULL)
+    {
+        run->next->prev = run;
+    }
+
+    heap->free_runs[bucket] = run;
+    heap->free_run_buckets |= (1U << bucket);
+
+    *heap_get_free_run_footer(heap, start_block_number + total_blocks - 1) = total_blocks;
+}
+
+static void heap_remove_free_run(struct heap *heap, struct heap_free_run *run)
+{
+    int bucket = heap_get_bucket_of_length(run->total_blocks);
+    if (run->prev != NULL)
+    {
+        run->prev->next = run->next;
+    }
+    else
+    {
+        heap->free_runs[bucket] = run->next;
+    }
+
+    if (run->next != NULL)
+    {
+        run->next->prev = run->prev;
+    }
+
+    if (heap->free_runs[bucket] == NULL)
+    {
+        heap->free_run_buckets &= ~(1U << bucket);
+    }
+}
+
+static void heap_account_blocks(struct heap *heap, int total_blocks)
+{ // Track blocks handed out (positive) or given back (negative).
+    heap->stats.blocks_in_use += total_blocks;
+    if (heap->stats.blocks_in_use > heap->stats.peak_blocks_in_use)
+    {
+        heap->stats.peak_blocks_in_use = heap->stats.blocks_in_use;
+    }
+}
+
 int heap_create(struct heap *heap, void *start, void *end, struct heap_table *table)
 {
     int result = 0;
@@ -74,8 +327,24 @@ int heap_create(struct heap *heap, void *start, void *end, struct heap_table *ta
         goto out;
     }
 
-    size_t table_size = sizeof(heap_block_table_entry) * table->total;
-    memset(table->entries, HEAP_BLOCK_TABLE_ENTRY_FREE, table_size);
+    if (table->type == HEAP_TABLE_TYPE_BITMAP)
+    {
+        size_t bitmap_size = HEAP_BITMAP_TOTAL_WORDS(table->total) * sizeof(uint32_t);
+        memset(table->free_bitmap, 0, bitmap_size);
+        memset(table->first_bitmap, 0, bitmap_size);
+        heap_bitmap_set_range(table->free_bitmap, 0, table->total, true);
+    }
+    else
+    {
+        size_t table_size = sizeof(heap_block_table_entry) * table->total;
+        memset(table->entries, HEAP_BLOCK_TABLE_ENTRY_FREE, table_size);
+    }
+
+    // The whole heap starts as a single free run.
+    if (table->total > 0)
+    {
+        heap_insert_free_run(heap, 0, table->total);
+    }
 
 out:
     return result;
@@ -91,7 +360,7 @@ void *get_physical_address_from_block_number(struct heap *heap, int num)
         goto out;
     }
 
-    address = heap->start_address + (num * HEAP_BLOCK_SIZE_BYTES);
+    address = heap_get_block_address(heap, num);
 
 out:
     return address;
@@ -120,6 +389,14 @@ int mark_blocks_taken(struct heap *heap, int start_block_number, int size)
         end_block_number = table->total - 1;
     }
 
+    heap_account_blocks(heap, end_block_number - start_block_number + 1);
+    if (table->type == HEAP_TABLE_TYPE_BITMAP)
+    {
+        heap_bitmap_set_range(table->free_bitmap, start_block_number, end_block_number - start_block_number + 1, false);
+        heap_bitmap_set_range(table->first_bitmap, start_block_number, 1, true);
+        goto out;
+    }
+
     table->entries[start_block_number] = HEAP_BLOCK_TABLE_ENTRY_TAKEN | HEAP_BLOCK_IS_FIRST;
 
     if (size > 1)
@@ -140,69 +417,96 @@ out:
     return result;
 }
 
-void mark_blocks_free(struct heap *heap, int num)
-{
+static void heap_release_run(struct heap *heap, int first_block_number, size_t total_blocks)
+{ // Index blocks that were just marked free, merged with the free runs around them.
     struct heap_table *table = heap->table;
-    int first_block_number = num;
-    while (first_block_number)
-    {
-        bool is_first_block = table->entries[num] & HEAP_BLOCK_IS_FIRST;
-        if (is_first_block)
-        {
-            break;
-        }
 
-        // If number is not first block,
-        // we need to determine the first block of the blocks.
-        first_block_number--;
+    // Coalesce with the free run on the left, its length is in the footer.
+    if (first_block_number > 0 && heap_table_block_is_free(table, first_block_number - 1))
+    {
+        size_t left_blocks = *heap_get_free_run_footer(heap, first_block_number - 1);
+        first_block_number -= left_blocks;
+        total_blocks += left_blocks;
+        heap_remove_free_run(heap, heap_get_block_address(heap, first_block_number));
     }
 
-    for (int i = first_block_number; i < table->total; i++)
+    // Coalesce with the free run on the right, its header is the next block.
+    int next_block_number = first_block_number + total_blocks;
+    if (next_block_number < table->total && heap_table_block_is_free(table, next_block_number))
     {
-        heap_block_table_entry entry = table->entries[i];
-        table->entries[i] = HEAP_BLOCK_TABLE_ENTRY_FREE;
-
-        if (!(entry & HEAP_BLOCK_HAS_NEXT))
-        {
-            break;
-        }
+        struct heap_free_run *right = heap_get_block_address(heap, next_block_number);
+        total_blocks += right->total_blocks;
+        heap_remove_free_run(heap, right);
     }
+
+    heap_insert_free_run(heap, first_block_number, total_blocks);
 }
 
-int get_free_blocks(struct heap *heap, uint32_t size)
+void mark_blocks_free(struct heap *heap, int num)
 {
     struct heap_table *table = heap->table;
+    if (num < 0 || num >= table->total || heap_table_block_is_free(table, num))
+    { // Not a block of this heap, or already free.
+        return;
+    }
+
+    // If number is not first block,
+    // we need to determine the first block of the blocks.
+    int first_block_number = heap_table_get_first_block(table, num);
+    size_t total_blocks = heap_table_release_blocks(table, first_block_number);
+    heap_account_blocks(heap, -(int)total_blocks);
+    heap->stats.total_frees++;
+    heap_release_run(heap, first_block_number, total_blocks);
+}
 
-    int free_block_count = 0;
+int get_free_blocks(struct heap *heap, uint32_t size)
+{
     int block_number = -ENOMEM;
-    for (size_t i = 0; i < table->total; i++)
+    struct heap_free_run *run = NULL;
+    if (size == 0)
     {
-        if (block_entry_is_free(table->entries[i]))
-        {
-            if (block_number == -ENOMEM)
-            { // Assign number of first block.
-                block_number = i;
-            }
+        goto out;
+    }
 
-            free_block_count++;
-            if (free_block_count == size)
+    // Every run of a bucket above `floor(log2(size))` is large enough,
+    // so when such bucket exists, its first run is used directly. Only
+    // the bucket of `size` itself may hold runs that are too short.
+    int bucket = heap_get_bucket_of_length(size);
+    int first_fit_bucket = (size == (1U << bucket)) ? bucket : bucket + 1;
+    uint32_t candidate_buckets = (first_fit_bucket < HEAP_FREE_RUN_BUCKETS)
+                                     ? heap->free_run_buckets & ~((1U << first_fit_bucket) - 1)
+                                     : 0;
+
+    if (candidate_buckets != 0)
+    {
+        run = heap->free_runs[__builtin_ctz(candidate_buckets)];
+    }
+    else
+    {
+        for (run = heap->free_runs[bucket]; run != NULL; run = run->next)
+        {
+            if (run->total_blocks >= size)
             {
                 break;
             }
         }
-        else
-        { // If block is taken, reset the counter.
-            free_block_count = 0;
-            block_number = -ENOMEM;
-        }
     }
 
-    if (free_block_count != size)
-    { // End of loop with free blocks, however, number
-      // of blocks is not enough as requested by the caller.
-        block_number = -ENOMEM;
+    if (run == NULL)
+    {
+        goto out;
+    }
+
+    // Take the blocks at the start of the run, the rest stays free.
+    block_number = get_block_number_from_physical_address(heap, run);
+    size_t remaining_blocks = run->total_blocks - size;
+    heap_remove_free_run(heap, run);
+    if (remaining_blocks > 0)
+    {
+        heap_insert_free_run(heap, block_number + size, remaining_blocks);
     }
 
+out:
     return block_number;
 }
 
@@ -229,10 +533,162 @@ void *malloc(struct heap *heap, size_t size)
 {
     size_t aligned_size = align_value_to_upper(size);
     uint32_t total_blocks = aligned_size / HEAP_BLOCK_SIZE_BYTES;
-    return malloc_blocks(heap, total_blocks);
+    void *address = malloc_blocks(heap, total_blocks);
+    if (address == NULL)
+    {
+        heap->stats.failed_allocations++;
+        return address;
+    }
+
+    heap->stats.total_allocations++;
+    heap->stats.bytes_requested += size;
+    heap->stats.bytes_allocated += aligned_size;
+    return address;
 }
 
 void free(struct heap *heap, void *ptr)
 {
     mark_blocks_free(heap, get_block_number_from_physical_address(heap, ptr));
-}
\ No newline at end of file
+}
+
+static int heap_get_allocation_start(struct heap *heap, void *ptr)
+{ // Block number of `ptr` if it is the start of an allocation.
+    struct heap_table *table = heap->table;
+    if (!heap_validate_alignment(ptr) || ptr < heap->start_address)
+    {
+        return -EINVAL;
+    }
+
+    int num = get_block_number_from_physical_address(heap, ptr);
+    if (num >= table->total || heap_table_block_is_free(table, num) || !heap_table_block_is_first(table, num))
+    {
+        return -EINVAL;
+    }
+
+    return num;
+}
+
+static int heap_resize_blocks(struct heap *heap, int first_block_number, size_t total_blocks, size_t new_total_blocks)
+{ // Resize an allocation without moving it, this only works when growing
+  // if the blocks right after the allocation are a long enough free run.
+    int res = 0;
+    struct heap_table *table = heap->table;
+    if (new_total_blocks < total_blocks)
+    {
+        heap_table_truncate_blocks(table, first_block_number, total_blocks, new_total_blocks);
+        heap_account_blocks(heap, (int)new_total_blocks - (int)total_blocks);
+        heap_release_run(heap, first_block_number + new_total_blocks, total_blocks - new_total_blocks);
+        goto out;
+    }
+
+    size_t extra_blocks = new_total_blocks - total_blocks;
+    if (extra_blocks == 0)
+    {
+        goto out;
+    }
+
+    int next_block_number = first_block_number + total_blocks;
+    if (next_block_number >= table->total || !heap_table_block_is_free(table, next_block_number))
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    struct heap_free_run *run = heap_get_block_address(heap, next_block_number);
+    if (run->total_blocks < extra_blocks)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    // Take the head of the free run, the rest stays free.
+    size_t remaining_blocks = run->total_blocks - extra_blocks;
+    heap_remove_free_run(heap, run);
+    if (remaining_blocks > 0)
+    {
+        heap_insert_free_run(heap, next_block_number + extra_blocks, remaining_blocks);
+    }
+
+    heap_table_extend_blocks(table, first_block_number, total_blocks, new_total_blocks);
+    heap_account_blocks(heap, extra_blocks);
+
+out:
+    return res;
+}
+
+void *realloc(struct heap *heap, void *ptr, size_t size)
+{
+    void *address = NULL;
+    int first_block_number = heap_get_allocation_start(heap, ptr);
+    if (first_block_number < 0)
+    {
+        goto out;
+    }
+
+    if (size == 0)
+    {
+        free(heap, ptr);
+        goto out;
+    }
+
+    size_t total_blocks = heap_table_get_total_blocks(heap->table, first_block_number);
+    size_t new_total_blocks = align_value_to_upper(size) / HEAP_BLOCK_SIZE_BYTES;
+    if (heap_resize_blocks(heap, first_block_number, total_blocks, new_total_blocks) == 0)
+    {
+        address = ptr;
+        goto out;
+    }
+
+    // No room behind the allocation, move it.
+    address = malloc(heap, size);
+    if (address == NULL)
+    {
+        goto out;
+    }
+
+    memcpy(address, ptr, total_blocks * HEAP_BLOCK_SIZE_BYTES);
+    free(heap, ptr);
+
+out:
+    return address;
+}
+
+size_t heap_get_allocation_size(struct heap *heap, void *ptr)
+{
+    int first_block_number = heap_get_allocation_start(heap, ptr);
+    if (first_block_number < 0)
+    {
+        return 0;
+    }
+
+    return heap_table_get_total_blocks(heap->table, first_block_number) * HEAP_BLOCK_SIZE_BYTES;
+}
+
+size_t heap_table_get_size_bytes(uint8_t type, size_t total_blocks)
+{
+    if (type == HEAP_TABLE_TYPE_BITMAP)
+    { // Free bitmap followed by the first block bitmap.
+        return 2 * HEAP_BITMAP_TOTAL_WORDS(total_blocks) * sizeof(uint32_t);
+    }
+
+    return total_blocks * sizeof(heap_block_table_entry);
+}
+
+void heap_get_stats(struct heap *heap, struct heap_stats *stats)
+{
+    memcpy(stats, &heap->stats, sizeof(struct heap_stats));
+
+    // The largest run is in the highest non empty bucket.
+    stats->largest_free_run = 0;
+    if (heap->free_run_buckets != 0)
+    {
+        int bucket = 31 - __builtin_clz(heap->free_run_buckets);
+        for (struct heap_free_run *run = heap->free_runs[bucket]; run != NULL; run = run->next)
+        {
+            if (run->total_blocks > stats->largest_free_run)
+            {
+                stats->largest_free_run = run->total_blocks;
+            }
+        }
+    }
+}
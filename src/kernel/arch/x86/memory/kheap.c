@@ -1,38 +1,398 @@
 #include <memory/heap.h>
+#include <memory/buddy.h>
 #include <memory/kheap.h>
+#include <memory/slab.h>
+#include <memory/frame.h>
 #include <video.h>
 #include <string.h>
+#include <errno.h>
+#include <stdbool.h>
+
+typedef int (*KHEAP_INIT_FUNCTION)(void *start, void *end);
+typedef size_t (*KHEAP_TABLE_SIZE_FUNCTION)(size_t total_blocks);
+typedef void *(*KHEAP_MALLOC_FUNCTION)(size_t size);
+typedef void (*KHEAP_FREE_FUNCTION)(void *ptr);
+typedef void *(*KHEAP_REALLOC_FUNCTION)(void *ptr, size_t size);
+typedef size_t (*KHEAP_SIZE_FUNCTION)(void *ptr);
+typedef size_t (*KHEAP_LARGEST_FREE_FUNCTION)();
+
+struct kheap_backend
+{ // Allocator that owns the kernel heap memory.
+    char name[16];
+    KHEAP_INIT_FUNCTION init;
+    KHEAP_TABLE_SIZE_FUNCTION table_size; // Bytes of metadata at `HEAP_TABLE_ADDRESS`.
+    KHEAP_MALLOC_FUNCTION malloc;
+    KHEAP_FREE_FUNCTION free;
+    KHEAP_REALLOC_FUNCTION realloc; // Resizes in place when it can, moves otherwise.
+    KHEAP_SIZE_FUNCTION size;       // Bytes really reserved for an allocation, 0 if invalid.
+    KHEAP_LARGEST_FREE_FUNCTION largest_free;
+};
 
 struct heap g_kernel_heap;
 struct heap_table g_kernel_heap_table;
+struct buddy_heap g_kernel_buddy_heap;
 
-void kheap_init()
+static int block_heap_init(void *start, void *end)
 {
-    int total_table_entries = KERNEL_HEAP_SIZE_BYTES / HEAP_BLOCK_SIZE_BYTES;
+    int total_table_entries = (end - start) / HEAP_BLOCK_SIZE_BYTES;
 
-    g_kernel_heap_table.entries = (heap_block_table_entry *)(HEAP_TABLE_ADDRESS);
+    g_kernel_heap_table.type = KERNEL_HEAP_TABLE_TYPE;
     g_kernel_heap_table.total = total_table_entries;
+    if (g_kernel_heap_table.type == HEAP_TABLE_TYPE_BITMAP)
+    { // Free bitmap first, then the first block bitmap right after it.
+        g_kernel_heap_table.free_bitmap = (uint32_t *)(HEAP_TABLE_ADDRESS);
+        g_kernel_heap_table.first_bitmap = g_kernel_heap_table.free_bitmap + HEAP_BITMAP_TOTAL_WORDS(total_table_entries);
+    }
+    else
+    {
+        g_kernel_heap_table.entries = (heap_block_table_entry *)(HEAP_TABLE_ADDRESS);
+    }
+
+    return heap_create(&g_kernel_heap, start, end, &g_kernel_heap_table);
+}
+
+static size_t block_heap_table_size(size_t total_blocks)
+{
+    return heap_table_get_size_bytes(KERNEL_HEAP_TABLE_TYPE, total_blocks);
+}
+
+static void *block_heap_malloc(size_t size)
+{
+    return malloc(&g_kernel_heap, size);
+}
+
+static void block_heap_free(void *ptr)
+{
+    free(&g_kernel_heap, ptr);
+}
+
+static void *block_heap_realloc(void *ptr, size_t size)
+{
+    return realloc(&g_kernel_heap, ptr, size);
+}
+
+static size_t block_heap_size(void *ptr)
+{
+    return heap_get_allocation_size(&g_kernel_heap, ptr);
+}
+
+static size_t block_heap_largest_free()
+{
+    struct heap_stats stats;
+    heap_get_stats(&g_kernel_heap, &stats);
+    return stats.largest_free_run * HEAP_BLOCK_SIZE_BYTES;
+}
+
+static int buddy_heap_init(void *start, void *end)
+{ // The buddy entries live where the block heap table would be.
+    return buddy_create(&g_kernel_buddy_heap, start, end, (buddy_block_entry *)(HEAP_TABLE_ADDRESS));
+}
+
+static size_t buddy_heap_table_size(size_t total_blocks)
+{
+    return total_blocks * sizeof(buddy_block_entry);
+}
+
+static void *buddy_heap_malloc(size_t size)
+{
+    return buddy_malloc(&g_kernel_buddy_heap, size);
+}
+
+static void buddy_heap_free(void *ptr)
+{
+    buddy_free(&g_kernel_buddy_heap, ptr);
+}
+
+static void *buddy_heap_realloc(void *ptr, size_t size)
+{
+    return buddy_realloc(&g_kernel_buddy_heap, ptr, size);
+}
+
+static size_t buddy_heap_size(void *ptr)
+{
+    return buddy_get_allocation_size(&g_kernel_buddy_heap, ptr);
+}
+
+static size_t buddy_heap_largest_free()
+{
+    return buddy_get_largest_free_block(&g_kernel_buddy_heap);
+}
+
+static struct kheap_backend kheap_backends[] =
+    {
+        [KERNEL_HEAP_BACKEND_BLOCK_TABLE] = {
+            name : "block table",
+            init : block_heap_init,
+            table_size : block_heap_table_size,
+            malloc : block_heap_malloc,
+            free : block_heap_free,
+            realloc : block_heap_realloc,
+            size : block_heap_size,
+            largest_free : block_heap_largest_free
+        },
+        [KERNEL_HEAP_BACKEND_BUDDY] = {
+            name : "buddy",
+            init : buddy_heap_init,
+            table_size : buddy_heap_table_size,
+            malloc : buddy_heap_malloc,
+            free : buddy_heap_free,
+            realloc : buddy_heap_realloc,
+            size : buddy_heap_size,
+            largest_free : buddy_heap_largest_free
+        }
+    };
+
+static struct kheap_backend *kheap = &kheap_backends[KERNEL_HEAP_BACKEND];
+static struct kheap_stats kheap_stats;
+
+// Bit per page frame, set for the frames `kzalloc()` handed out of the
+// zeroed pool. Only those go back to the frame allocator on free.
+static uint32_t *kheap_frames_bitmap = NULL;
+static size_t kheap_total_frames = 0;
+
+#if KHEAP_DEBUG
+static struct kheap_call_site kheap_call_sites[KHEAP_DEBUG_TOTAL_CALL_SITES];
+#endif
+
+static void *kheap_alloc_slab_page()
+{
+    return kheap->malloc(SLAB_PAGE_SIZE);
+}
+
+static void kheap_free_slab_page(void *page)
+{
+    kheap->free(page);
+}
+
+static void *kheap_reserve_memory(size_t *size_out)
+{ // Take a contiguous share of the free page frames for the heap.
+    size_t total_blocks = (frame_get_total_free() / 100) * KERNEL_HEAP_MEMORY_SHARE;
+    if (total_blocks > KERNEL_HEAP_MAX_SIZE_BYTES / HEAP_BLOCK_SIZE_BYTES)
+    {
+        total_blocks = KERNEL_HEAP_MAX_SIZE_BYTES / HEAP_BLOCK_SIZE_BYTES;
+    }
+
+    // The heap metadata has to fit in the conventional memory region.
+    while (kheap->table_size(total_blocks) > HEAP_TABLE_MAX_SIZE_BYTES)
+    {
+        total_blocks /= 2;
+    }
+
+    // Usable RAM may be split by holes, settle for a smaller heap if needed.
+    void *start = NULL;
+    while (total_blocks >= KERNEL_HEAP_MIN_SIZE_BYTES / HEAP_BLOCK_SIZE_BYTES)
+    {
+        start = frame_alloc_contiguous(total_blocks);
+        if (start != NULL)
+        {
+            break;
+        }
+
+        total_blocks /= 2;
+    }
+
+    *size_out = total_blocks * HEAP_BLOCK_SIZE_BYTES;
+    return start;
+}
 
-    int res = heap_create(&g_kernel_heap,
-                          (void *)(KERNEL_HEAP_START_ADDRESS),
-                          (void *)(KERNEL_HEAP_START_ADDRESS + KERNEL_HEAP_SIZE_BYTES),
-                          &g_kernel_heap_table);
+void kheap_init()
+{
+    int res = -ENOMEM;
+    size_t size = 0;
+    void *start = kheap_reserve_memory(&size);
+    if (start != NULL)
+    {
+        res = kheap->init(start, start + size);
+    }
 
     if (res < 0)
     {
         print("Failed to initialize heap memory.\n");
+        return;
+    }
+
+    // Small objects are carved out of heap blocks by the slab caches.
+    slab_init(kheap_alloc_slab_page, kheap_free_slab_page);
+
+    // Without the bitmap `kzalloc()` takes everything from the heap.
+    kheap_total_frames = frame_get_total();
+    kheap_frames_bitmap = kheap->malloc(((kheap_total_frames + 31) / 32) * sizeof(uint32_t));
+    if (kheap_frames_bitmap != NULL)
+    {
+        memset(kheap_frames_bitmap, 0, ((kheap_total_frames + 31) / 32) * sizeof(uint32_t));
+    }
+
+    memset(&kheap_stats, 0, sizeof(kheap_stats));
+    kheap_stats.heap_size_bytes = size;
+    print("Initialize heap successfully, backend: ");
+    print(kheap->name);
+    print(", size: ");
+    print_number(size / 1024);
+    print(" KiB.\n");
+}
+
+static bool kheap_owns_frame(void *ptr)
+{ // Page sized zeroed allocations may be page frames from outside the heap,
+  // any other page aligned pointer is not ours to release.
+    size_t num = (uint32_t)ptr / FRAME_SIZE_BYTES;
+    if (kheap_frames_bitmap == NULL || ((uint32_t)ptr % FRAME_SIZE_BYTES) || num >= kheap_total_frames)
+    {
+        return false;
+    }
+
+    return kheap_frames_bitmap[num / 32] & (1U << (num % 32));
+}
+
+static void kheap_set_frame_owned(void *ptr, bool owned)
+{
+    size_t num = (uint32_t)ptr / FRAME_SIZE_BYTES;
+    if (owned)
+    {
+        kheap_frames_bitmap[num / 32] |= (1U << (num % 32));
+    }
+    else
+    {
+        kheap_frames_bitmap[num / 32] &= ~(1U << (num % 32));
+    }
+}
+
+static size_t kheap_get_size(void *ptr)
+{ // Slab objects are never block aligned, heap allocations always are.
+    if (slab_owns(ptr))
+    {
+        return slab_get_object_size(ptr);
+    }
+
+    return kheap_owns_frame(ptr) ? FRAME_SIZE_BYTES : kheap->size(ptr);
+}
+
+static void *kheap_alloc(size_t size)
+{
+    if (size > 0 && size <= SLAB_MAX_OBJECT_SIZE)
+    {
+        return slab_alloc(size);
+    }
+
+    return kheap->malloc(size);
+}
+
+static void kheap_release(void *ptr)
+{
+    if (slab_owns(ptr))
+    {
+        slab_free(ptr);
+        return;
+    }
+
+    if (kheap_owns_frame(ptr))
+    {
+        kheap_set_frame_owned(ptr, false);
+        frame_free(ptr);
+        return;
+    }
+
+    kheap->free(ptr);
+}
+
+static void *kheap_resize(void *ptr, size_t size, size_t old_size)
+{
+    if (!slab_owns(ptr) && !kheap_owns_frame(ptr))
+    {
+        return kheap->realloc(ptr, size);
+    }
+
+    // Slab objects and frames can only be reused while the new size fits.
+    if (size <= old_size)
+    {
+        return ptr;
+    }
+
+    void *new_ptr = kheap_alloc(size);
+    if (new_ptr == NULL)
+    {
+        return NULL;
+    }
+
+    memcpy(new_ptr, ptr, old_size);
+    kheap_release(ptr);
+    return new_ptr;
+}
+
+#if KHEAP_DEBUG
+static void kheap_tag_call_site(void *caller, size_t size)
+{ // Call sites past the table size are only counted in the global stats.
+    for (int i = 0; i < KHEAP_DEBUG_TOTAL_CALL_SITES; i++)
+    {
+        struct kheap_call_site *site = &kheap_call_sites[i];
+        if (site->caller != caller && site->caller != NULL)
+        {
+            continue;
+        }
+
+        site->caller = caller;
+        site->total_allocations++;
+        site->bytes_requested += size;
+        return;
+    }
+}
+#endif
+
+static void kheap_account_usage(size_t old_size, size_t new_size)
+{
+    kheap_stats.bytes_in_use += new_size;
+    kheap_stats.bytes_in_use -= old_size;
+    if (kheap_stats.bytes_in_use > kheap_stats.peak_bytes_in_use)
+    {
+        kheap_stats.peak_bytes_in_use = kheap_stats.bytes_in_use;
+    }
+}
+
+static void kheap_account_alloc(void *ptr, size_t size, size_t old_size, void *caller)
+{
+    if (ptr == NULL)
+    {
+        kheap_stats.failed_allocations++;
+        return;
     }
-    print("Initialize heap successfully.\n");
+
+    size_t allocated = kheap_get_size(ptr);
+    kheap_stats.total_allocations++;
+    kheap_stats.bytes_requested += size;
+    kheap_stats.bytes_allocated += allocated;
+    kheap_account_usage(old_size, allocated);
+
+#if KHEAP_DEBUG
+    kheap_tag_call_site(caller, size);
+#endif
+}
+
+static void *kheap_malloc_from(size_t size, void *caller)
+{
+    void *ptr = kheap_alloc(size);
+    kheap_account_alloc(ptr, size, 0, caller);
+    return ptr;
 }
 
 void *kmalloc(size_t size)
 {
-    return malloc(&g_kernel_heap, size);
+    return kheap_malloc_from(size, __builtin_return_address(0));
 }
 
 void *kzalloc(size_t size)
 {
-    void *ptr = kmalloc(size);
+    void *ptr = NULL;
+    if (size > SLAB_MAX_OBJECT_SIZE && size <= FRAME_SIZE_BYTES && kheap_frames_bitmap != NULL)
+    { // A frame from the zeroed pool skips the clearing.
+        ptr = frame_alloc_zeroed();
+        if (ptr != NULL)
+        {
+            kheap_set_frame_owned(ptr, true);
+            kheap_account_alloc(ptr, size, 0, __builtin_return_address(0));
+            return ptr;
+        }
+    }
+
+    ptr = kheap_malloc_from(size, __builtin_return_address(0));
     if (ptr == NULL)
     {
         return ptr;
@@ -44,5 +404,74 @@ void *kzalloc(size_t size)
 
 void kfree(void *ptr)
 {
-    return free(&g_kernel_heap, ptr);
-}
\ No newline at end of file
+    if (ptr == NULL)
+    {
+        return;
+    }
+
+    size_t size = kheap_get_size(ptr);
+    if (size == 0)
+    { // Not an allocation of ours.
+        return;
+    }
+
+    kheap_stats.total_frees++;
+    kheap_account_usage(size, 0);
+    kheap_release(ptr);
+}
+
+void *krealloc(void *ptr, size_t size)
+{
+    if (ptr == NULL)
+    {
+        return kheap_malloc_from(size, __builtin_return_address(0));
+    }
+
+    if (size == 0)
+    {
+        kfree(ptr);
+        return NULL;
+    }
+
+    size_t old_size = kheap_get_size(ptr);
+    if (old_size == 0)
+    {
+        return NULL;
+    }
+
+    // The resized allocation replaces the old one in the usage stats.
+    void *new_ptr = kheap_resize(ptr, size, old_size);
+    kheap_account_alloc(new_ptr, size, old_size, __builtin_return_address(0));
+    return new_ptr;
+}
+
+void kheap_get_stats(struct kheap_stats *stats)
+{
+    memcpy(stats, &kheap_stats, sizeof(struct kheap_stats));
+    stats->largest_free_bytes = kheap->largest_free();
+}
+
+int kheap_get_call_site(int index, struct kheap_call_site *site)
+{
+#if KHEAP_DEBUG
+    if (index < 0 || index >= KHEAP_DEBUG_TOTAL_CALL_SITES)
+    {
+        return -EINVAL;
+    }
+
+    if (kheap_call_sites[index].caller == NULL)
+    {
+        return -ENOENT;
+    }
+
+    memcpy(site, &kheap_call_sites[index], sizeof(struct kheap_call_site));
+    return 0;
+#else
+    return -ENOENT;
+#endif
+}
+
+int kheap_get_slab_stats(int index, struct slab_cache_stats *stats)
+{
+    return slab_get_cache_stats(index, stats);
+}
@@ -1,12 +1,18 @@
 #include <memory/paging.h>
 #include <memory/kheap.h>
+#include <memory/frame.h>
 #include <stdbool.h>
+#include <string.h>
 #include <errno.h>
 
 extern void paging_load_directory(uint32_t *directory);
+extern int paging_enable_large_pages();
+extern int paging_enable_global_pages();
 
 static struct paging_4GB_chunk *kernel_directory = NULL;
 static uint32_t *current_directory = NULL;
+static bool large_pages_enabled = false;
+static bool global_pages_enabled = false;
 
 void switch_to_kernel_page()
 {
@@ -21,15 +27,51 @@ void paging_install_kernel_page(struct paging_4GB_chunk *kernel_page)
     }
 }
 
+void paging_initialize_large_pages()
+{
+    large_pages_enabled = paging_enable_large_pages();
+}
+
+void paging_initialize_global_pages()
+{
+    global_pages_enabled = paging_enable_global_pages();
+}
+
 static bool paging_check_address_is_aligned(void *addr)
 {
     return ((uint32_t)addr % PAGING_PAGE_SIZE) == 0;
 }
 
+static uint32_t *paging_alloc_table()
+{ // Page directories and page tables are exactly one page frame.
+    return frame_alloc_zeroed();
+}
+
+static void paging_free_table(uint32_t *table)
+{
+    frame_free(table);
+}
+
+static bool paging_is_user_directory_index(int index)
+{
+    return index >= PAGING_DIRECTORY_INDEX(USER_SPACE_START) && index < PAGING_DIRECTORY_INDEX(USER_SPACE_END);
+}
+
+static uint32_t paging_get_global_flag(int directory_index, uint8_t flags)
+{ // Kernel only mappings outside the user window are the same in every
+  // address space, their translations can outlive a CR3 switch.
+    if (!global_pages_enabled || (flags & PAGING_ACCESS_FROM_ALL) || paging_is_user_directory_index(directory_index))
+    {
+        return 0;
+    }
+
+    return PAGING_IS_GLOBAL;
+}
+
 struct paging_4GB_chunk *make_new_4GB_virtual_memory_address_space(uint8_t flags)
 {
     /* 1. Creating a Blank Page Directory. The page directory should have exactly 1024 entries.*/
-    uint32_t *directory = kzalloc(sizeof(uint32_t) * PAGING_TOTAL_ENTRIES_PER_TABLE);
+    uint32_t *directory = paging_alloc_table();
 
     /* 2. Creating Page Tables, each entry in the Page Directory is a pointer to a Page Table.*/
     int offset = 0;
@@ -37,20 +79,28 @@ struct paging_4GB_chunk *make_new_4GB_virtual_memory_address_space(uint8_t flags
     { // this For loop make 1024 page tables,
       // initialise them with the flags,
       // and causes the Page Directory Entries point to them.
+        uint32_t global = paging_get_global_flag(i, flags);
 
-        uint32_t *entry = kzalloc(sizeof(uint32_t) * PAGING_TOTAL_ENTRIES_PER_TABLE);
+        if (large_pages_enabled)
+        { // A single directory entry maps the 4 megabytes, no table needed.
+            directory[i] = offset | flags | global | PAGING_IS_WRITEABLE | PAGING_IS_LARGE_PAGE;
+            offset += PAGING_LARGE_PAGE_SIZE;
+            continue;
+        }
+
+        uint32_t *entry = paging_alloc_table();
         for (int j = 0; j < PAGING_TOTAL_ENTRIES_PER_TABLE; j++)
         { // We will fill all 1024 entries in the table, mapping 4 megabytes.
 
             // Bits 31-12 of address, 11-0 of flags.
             // As the address is page aligned, it will always leave 12 bits zeroed.
-            entry[j] = (offset + (j * PAGING_PAGE_SIZE)) | flags;
+            entry[j] = (offset + (j * PAGING_PAGE_SIZE)) | flags | global;
         }
 
         offset += (PAGING_TOTAL_ENTRIES_PER_TABLE * PAGING_PAGE_SIZE);
 
         // Put the Page Table in the Page Directory.
-        directory[i] = (uint32_t)entry | flags | PAGING_IS_WRITEABLE;
+        directory[i] = (uint32_t)entry | flags | PAGING_IS_WRITEABLE | PAGING_PRIVATE_TABLE;
     }
 
     /* 3. Return 4GB chunk object for the caller. */
@@ -59,12 +109,108 @@ struct paging_4GB_chunk *make_new_4GB_virtual_memory_address_space(uint8_t flags
     return chunk_4GB;
 }
 
+struct paging_4GB_chunk *make_new_user_virtual_memory_address_space()
+{ // Only the page directory is new, everything outside the user window
+  // points to the page tables of the kernel directory.
+    uint32_t *directory = paging_alloc_table();
+    if (directory == NULL)
+    {
+        return NULL;
+    }
+
+    for (int i = 0; i < PAGING_TOTAL_ENTRIES_PER_TABLE; i++)
+    {
+        if (!paging_is_user_directory_index(i))
+        {
+            directory[i] = kernel_directory->directory_entry[i] & ~PAGING_PRIVATE_TABLE;
+        }
+    }
+
+    struct paging_4GB_chunk *chunk_4GB = kzalloc(sizeof(struct paging_4GB_chunk));
+    if (chunk_4GB == NULL)
+    {
+        paging_free_table(directory);
+        return NULL;
+    }
+
+    chunk_4GB->directory_entry = directory;
+    return chunk_4GB;
+}
+
+static uint32_t *paging_get_private_table(struct paging_4GB_chunk *page, uint32_t directory_index)
+{ // Page table of the directory that can be written, allocated on first use.
+  // A table shared with the kernel directory is copied before it changes.
+    uint32_t entry = page->directory_entry[directory_index];
+    if (entry & PAGING_PRIVATE_TABLE)
+    {
+        return (uint32_t *)(entry & 0xFFFFF000);
+    }
+
+    uint32_t *table = paging_alloc_table();
+    if (table == NULL)
+    {
+        return NULL;
+    }
+
+    uint32_t flags = PAGING_IS_PRESENT | PAGING_IS_WRITEABLE | PAGING_ACCESS_FROM_ALL;
+    if ((entry & PAGING_IS_PRESENT) && (entry & PAGING_IS_LARGE_PAGE))
+    { // Split the large page into 4 KiB pages with the same flags.
+        flags = entry & PAGING_ENTRY_FLAGS_MASK;
+        for (int i = 0; i < PAGING_TOTAL_ENTRIES_PER_TABLE; i++)
+        {
+            table[i] = ((entry & PAGING_LARGE_PAGE_ADDRESS_MASK) + (i * PAGING_PAGE_SIZE)) | flags | (entry & PAGING_IS_GLOBAL);
+        }
+    }
+    else if (entry & PAGING_IS_PRESENT)
+    {
+        memcpy(table, (uint32_t *)(entry & 0xFFFFF000), PAGING_PAGE_SIZE);
+        flags = entry & 0xFFF;
+    }
+
+    page->directory_entry[directory_index] = (uint32_t)table | flags | PAGING_PRIVATE_TABLE;
+    return table;
+}
+
 void switch_to_page(struct paging_4GB_chunk *directory)
 {
+    if (directory->directory_entry == current_directory)
+    { // Reloading CR3 would only flush the TLB for nothing.
+        return;
+    }
+
     paging_load_directory(directory->directory_entry);
     current_directory = directory->directory_entry;
 }
 
+void paging_invalidate_range(void *start, void *end)
+{
+    uint32_t first = (uint32_t)start & ~(PAGING_PAGE_SIZE - 1);
+    uint32_t total_pages = ((uint32_t)paging_align_address(end) - first) / PAGING_PAGE_SIZE;
+    if (total_pages > PAGING_INVALIDATE_PAGES_LIMIT && global_pages_enabled)
+    { // The range may hold global kernel pages, which CR3 writes keep.
+        paging_flush_global_tlb();
+        return;
+    }
+
+    if (total_pages > PAGING_INVALIDATE_PAGES_LIMIT)
+    {
+        paging_flush_tlb();
+        return;
+    }
+
+    for (uint32_t i = 0; i < total_pages; i++)
+    {
+        paging_invalidate_page((void *)(first + (i * PAGING_PAGE_SIZE)));
+    }
+}
+
+static bool paging_is_loaded(struct paging_4GB_chunk *page, uint32_t directory_index)
+{ // Whether a change to the directory can be cached in the TLB right now.
+  // Kernel tables are shared, so a change there shows in every address space.
+    return page->directory_entry == current_directory ||
+           (page == kernel_directory && !paging_is_user_directory_index(directory_index));
+}
+
 static int paging_get_indexes(void *virtual_address, uint32_t *directory_index_out, uint32_t *table_index_out)
 {
     int result = 0;
@@ -98,9 +244,19 @@ int paging_set_entry_for_virtual_address(struct paging_4GB_chunk *page, void *vi
         return res;
     }
 
-    uint32_t entry = page->directory_entry[directory_index];
-    uint32_t *table = (uint32_t *)(entry & 0xfffff000);
+    uint32_t *table = paging_get_private_table(page, directory_index);
+    if (table == NULL)
+    {
+        result = -ENOMEM;
+        goto out;
+    }
+
+    uint32_t old_entry = table[table_index];
     table[table_index] = val;
+    if ((old_entry & PAGING_IS_PRESENT) && paging_is_loaded(page, directory_index))
+    { // Not present entries are never cached.
+        paging_invalidate_page(virtual_address);
+    }
 
 out:
     return result;
@@ -108,13 +264,23 @@ out:
 
 void release_4GB_virtual_memory_address_space(struct paging_4GB_chunk *page)
 {
+    if (page->directory_entry == current_directory)
+    { // Its frame may come back as another directory, which has to be loaded for real.
+        switch_to_kernel_page();
+    }
+
     for (int i = 0; i < 1024; i++)
-    {
+    { // Tables shared with the kernel directory are not ours to free.
         uint32_t entry = page->directory_entry[i];
+        if (!(entry & PAGING_PRIVATE_TABLE))
+        {
+            continue;
+        }
+
         uint32_t *table = (uint32_t *)(entry & 0xFFFFF000);
-        kfree(table);
+        paging_free_table(table);
     }
-    kfree(page->directory_entry);
+    paging_free_table(page->directory_entry);
     kfree(page);
 }
 
@@ -131,6 +297,35 @@ int paging_map_page(struct paging_4GB_chunk *page,
     return paging_set_entry_for_virtual_address(page, virt, (uint32_t)phys | flags);
 }
 
+int paging_map_large_page(struct paging_4GB_chunk *page,
+                          void *virt,
+                          void *phys,
+                          int flags)
+{
+    if (!large_pages_enabled ||
+        (uint32_t)virt % PAGING_LARGE_PAGE_SIZE ||
+        (uint32_t)phys % PAGING_LARGE_PAGE_SIZE)
+    {
+        return -EINVAL;
+    }
+
+    // The large page replaces whatever table was mapping the region.
+    uint32_t directory_index = PAGING_DIRECTORY_INDEX(virt);
+    uint32_t entry = page->directory_entry[directory_index];
+    if (entry & PAGING_PRIVATE_TABLE)
+    {
+        paging_free_table((uint32_t *)(entry & 0xFFFFF000));
+    }
+
+    page->directory_entry[directory_index] = (uint32_t)phys | flags | PAGING_IS_LARGE_PAGE;
+    if ((entry & PAGING_IS_PRESENT) && paging_is_loaded(page, directory_index))
+    {
+        paging_invalidate_range(virt, virt + PAGING_LARGE_PAGE_SIZE);
+    }
+
+    return 0;
+}
+
 static int paging_map_memory_by_range(struct paging_4GB_chunk *page,
                                       void *virt,
                                       void *phys,
@@ -138,14 +333,25 @@ static int paging_map_memory_by_range(struct paging_4GB_chunk *page,
                                       int flags)
 {
     int res = 0;
-    for (int i = 0; i < total_pages; i++)
+    for (int i = 0; i < total_pages;)
     {
+        // Use a large page for every 4 megabytes that are aligned on both sides.
+        if (total_pages - i >= PAGING_TOTAL_ENTRIES_PER_TABLE &&
+            paging_map_large_page(page, virt, phys, flags) == 0)
+        {
+            i += PAGING_TOTAL_ENTRIES_PER_TABLE;
+            virt += PAGING_LARGE_PAGE_SIZE;
+            phys += PAGING_LARGE_PAGE_SIZE;
+            continue;
+        }
+
         res = paging_map_page(page, virt, phys, flags);
-        if (res == 0)
+        if (res < 0)
         {
             break;
         }
 
+        i++;
         virt += PAGING_PAGE_SIZE;
         phys += PAGING_PAGE_SIZE;
     }
@@ -213,6 +419,17 @@ uint32_t paging_get_entry_of_address(struct paging_4GB_chunk *page, void *virt)
     paging_get_indexes(virt, &dir_index, &table_index);
     
     uint32_t entry = page->directory_entry[dir_index];
+    if (!(entry & PAGING_IS_PRESENT))
+    { // Nothing was ever mapped in this part of the user window.
+        return 0;
+    }
+
+    if (entry & PAGING_IS_LARGE_PAGE)
+    { // Entry the page would have if the large page was split.
+        return ((entry & PAGING_LARGE_PAGE_ADDRESS_MASK) + (table_index * PAGING_PAGE_SIZE)) |
+               (entry & (PAGING_ENTRY_FLAGS_MASK | PAGING_IS_GLOBAL));
+    }
+
     uint32_t* table = (uint32_t*)(entry  & 0xFFFFF000);
 
     return table[table_index];
@@ -0,0 +1,217 @@
+#include <memory/slab.h>
+#include <errno.h>
+#include <string.h>
+
+// Objects start after the page header, aligned to 16 bytes. Because the
+// header is never empty, a slab object is never page aligned, this is
+// how `slab_owns()` tells slab objects apart from heap blocks.
+#define SLAB_OBJECT_ALIGNMENT 16
+#define SLAB_FIRST_OBJECT_OFFSET \
+    ((sizeof(struct slab_page) + SLAB_OBJECT_ALIGNMENT - 1) & ~(SLAB_OBJECT_ALIGNMENT - 1))
+
+static struct slab_cache slab_caches[SLAB_TOTAL_CACHES];
+static SLAB_PAGE_ALLOC_FUNCTION slab_alloc_page = NULL;
+static SLAB_PAGE_FREE_FUNCTION slab_free_page = NULL;
+
+static int slab_get_cache_index(size_t size)
+{ // Index of the smallest cache which object size fits the request.
+    int index = 0;
+    size_t object_size = SLAB_MIN_OBJECT_SIZE;
+    while (object_size < size)
+    {
+        object_size <<= 1;
+        index++;
+    }
+
+    return index;
+}
+
+static struct slab_page *slab_get_page_of_object(void *ptr)
+{
+    return (struct slab_page *)((uint32_t)ptr & ~(SLAB_PAGE_SIZE - 1));
+}
+
+static void slab_link_page(struct slab_cache *cache, struct slab_page *page)
+{ // Push the page at the head of the partial list.
+    page->prev = NULL;
+    page->next = cache->partial;
+    if (cache->partial != NULL)
+    {
+        cache->partial->prev = page;
+    }
+
+    cache->partial = page;
+}
+
+static void slab_unlink_page(struct slab_cache *cache, struct slab_page *page)
+{
+    if (page->prev != NULL)
+    {
+        page->prev->next = page->next;
+    }
+    else
+    {
+        cache->partial = page->next;
+    }
+
+    if (page->next != NULL)
+    {
+        page->next->prev = page->prev;
+    }
+
+    page->next = NULL;
+    page->prev = NULL;
+}
+
+static struct slab_page *slab_make_new_page(struct slab_cache *cache)
+{
+    struct slab_page *page = slab_alloc_page();
+    if (page == NULL)
+    {
+        goto out;
+    }
+
+    page->magic = SLAB_PAGE_MAGIC;
+    page->cache = cache;
+    page->next = NULL;
+    page->prev = NULL;
+    page->free_list = NULL;
+    page->in_use = 0;
+    page->capacity = (SLAB_PAGE_SIZE - SLAB_FIRST_OBJECT_OFFSET) / cache->object_size;
+
+    // Thread all objects of the page into the free list, in address order.
+    char *object = (char *)page + SLAB_FIRST_OBJECT_OFFSET + (page->capacity - 1) * cache->object_size;
+    for (int i = 0; i < page->capacity; i++)
+    {
+        struct slab_object *free_object = (struct slab_object *)object;
+        free_object->next = page->free_list;
+        page->free_list = free_object;
+        object -= cache->object_size;
+    }
+
+    cache->stats.total_pages++;
+    cache->stats.total_objects += page->capacity;
+    slab_link_page(cache, page);
+
+out:
+    return page;
+}
+
+static void slab_release_page(struct slab_cache *cache, struct slab_page *page)
+{
+    slab_unlink_page(cache, page);
+    cache->stats.total_pages--;
+    cache->stats.total_objects -= page->capacity;
+
+    // Wipe the magic, the block may come back later as a plain heap block.
+    page->magic = 0;
+    slab_free_page(page);
+}
+
+void slab_init(SLAB_PAGE_ALLOC_FUNCTION alloc_page, SLAB_PAGE_FREE_FUNCTION free_page)
+{
+    memset(slab_caches, 0, sizeof(slab_caches));
+    size_t object_size = SLAB_MIN_OBJECT_SIZE;
+    for (int i = 0; i < SLAB_TOTAL_CACHES; i++)
+    {
+        slab_caches[i].object_size = object_size;
+        slab_caches[i].stats.object_size = object_size;
+        object_size <<= 1;
+    }
+
+    slab_alloc_page = alloc_page;
+    slab_free_page = free_page;
+}
+
+void *slab_alloc(size_t size)
+{
+    void *ptr = NULL;
+    if (size == 0 || size > SLAB_MAX_OBJECT_SIZE || slab_alloc_page == NULL)
+    {
+        goto out;
+    }
+
+    struct slab_cache *cache = &slab_caches[slab_get_cache_index(size)];
+    struct slab_page *page = cache->partial;
+    if (page == NULL)
+    {
+        page = slab_make_new_page(cache);
+        if (page == NULL)
+        {
+            goto out;
+        }
+    }
+
+    struct slab_object *object = page->free_list;
+    page->free_list = object->next;
+    page->in_use++;
+    if (page->free_list == NULL)
+    { // The page is full, it only comes back to the partial list on free.
+        slab_unlink_page(cache, page);
+    }
+
+    cache->stats.objects_in_use++;
+    cache->stats.total_allocations++;
+    ptr = object;
+
+out:
+    return ptr;
+}
+
+void slab_free(void *ptr)
+{
+    struct slab_page *page = slab_get_page_of_object(ptr);
+    if (page->magic != SLAB_PAGE_MAGIC)
+    { // Not an object of ours.
+        return;
+    }
+
+    struct slab_cache *cache = page->cache;
+    bool was_full = (page->free_list == NULL);
+
+    struct slab_object *object = ptr;
+    object->next = page->free_list;
+    page->free_list = object;
+    page->in_use--;
+
+    cache->stats.objects_in_use--;
+    cache->stats.total_frees++;
+
+    if (was_full)
+    {
+        slab_link_page(cache, page);
+    }
+
+    if (page->in_use == 0 && (page->next != NULL || page->prev != NULL))
+    { // Give empty pages back to the heap, but keep the last partial page
+      // of the cache around so alloc/free pairs do not bounce a page.
+        slab_release_page(cache, page);
+    }
+}
+
+size_t slab_get_object_size(void *ptr)
+{
+    struct slab_page *page = slab_get_page_of_object(ptr);
+    if (page->magic != SLAB_PAGE_MAGIC)
+    {
+        return 0;
+    }
+
+    return page->cache->object_size;
+}
+
+bool slab_owns(void *ptr)
+{
+    return ((uint32_t)ptr % SLAB_PAGE_SIZE) != 0;
+}
+
+int slab_get_cache_stats(int index, struct slab_cache_stats *stats)
+{
+    if (index < 0 || index >= SLAB_TOTAL_CACHES)
+    {
+        return -EINVAL;
+    }
+
+    memcpy(stats, &slab_caches[index].stats, sizeof(struct slab_cache_stats));
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include <pci/pci.h>
+#include <io.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+
+static uint32_t pci_get_config_address(uint8_t bus, uint8_t device, uint8_t function, uint8_t offset)
+{ // Registers are 32 bits wide, the low bits of the offset are ignored.
+    return PCI_CONFIG_ENABLE |
+           ((uint32_t)bus << 16) |
+           ((uint32_t)device << 11) |
+           ((uint32_t)function << 8) |
+           (offset & 0xFC);
+}
+
+static uint32_t pci_read(uint8_t bus, uint8_t device, uint8_t function, uint8_t offset)
+{
+    outl(PCI_CONFIG_ADDRESS_PORT, pci_get_config_address(bus, device, function, offset));
+    return inl(PCI_CONFIG_DATA_PORT);
+}
+
+uint32_t pci_config_read(struct pci_device *device, uint8_t offset)
+{
+    return pci_read(device->bus, device->device, device->function, offset);
+}
+
+void pci_config_write(struct pci_device *device, uint8_t offset, uint32_t val)
+{
+    outl(PCI_CONFIG_ADDRESS_PORT, pci_get_config_address(device->bus, device->device, device->function, offset));
+    outl(PCI_CONFIG_DATA_PORT, val);
+}
+
+static bool pci_probe_function(uint8_t bus, uint8_t device, uint8_t function, struct pci_device *out)
+{ // Fill `out` if the function exists.
+    uint32_t id = pci_read(bus, device, function, PCI_REGISTER_ID);
+    if ((id & 0xFFFF) == PCI_INVALID_VENDOR_ID)
+    {
+        return false;
+    }
+
+    uint32_t class = pci_read(bus, device, function, PCI_REGISTER_CLASS);
+    out->bus = bus;
+    out->device = device;
+    out->function = function;
+    out->vendor_id = id & 0xFFFF;
+    out->device_id = id >> 16;
+    out->class_code = class >> 24;
+    out->subclass = (class >> 16) & 0xFF;
+    out->prog_if = (class >> 8) & 0xFF;
+    return true;
+}
+
+int pci_find_device(uint8_t class_code, uint8_t subclass, struct pci_device *device)
+{
+    struct pci_device candidate;
+    for (int bus = 0; bus < PCI_MAX_BUSES; bus++)
+    {
+        for (int slot = 0; slot < PCI_MAX_DEVICES; slot++)
+        {
+            if (!pci_probe_function(bus, slot, 0, &candidate))
+            {
+                continue;
+            }
+
+            // Only multi function devices have functions other than 0.
+            uint32_t header = pci_read(bus, slot, 0, PCI_REGISTER_HEADER_TYPE) >> 16;
+            int total_functions = (header & PCI_HEADER_IS_MULTI_FUNCTION) ? PCI_MAX_FUNCTIONS : 1;
+            for (int function = 0; function < total_functions; function++)
+            {
+                if (function > 0 && !pci_probe_function(bus, slot, function, &candidate))
+                {
+                    continue;
+                }
+
+                if (candidate.class_code == class_code && candidate.subclass == subclass)
+                {
+                    memcpy(device, &candidate, sizeof(struct pci_device));
+                    return 0;
+                }
+            }
+        }
+    }
+
+    return -ENODEV;
+}
+
+uint32_t pci_get_bar(struct pci_device *device, int index)
+{
+    if (index < 0 || index >= PCI_TOTAL_BARS)
+    {
+        return 0;
+    }
+
+    return pci_config_read(device, PCI_REGISTER_BAR0 + (index * sizeof(uint32_t)));
+}
+
+void pci_enable_command(struct pci_device *device, uint16_t bits)
+{ // The status register shares the double word, its bits are cleared by writing ones.
+    uint32_t val = pci_config_read(device, PCI_REGISTER_COMMAND) & 0xFFFF;
+    pci_config_write(device, PCI_REGISTER_COMMAND, val | bits);
+}
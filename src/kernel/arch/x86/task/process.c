@@ -5,6 +5,7 @@
 #include <string.h>
 #include <strings.h>
 #include <errno.h>
+#include <stdbool.h>
 #include <fs/file.h>
 #include <video.h>
 
@@ -32,9 +33,54 @@ static struct process *get_process_by_id(int id)
     return processes[id];
 }
 
+static int process_get_file(struct process *process, int fd)
+{ // Translate a descriptor of the process into the VFS descriptor.
+    if (fd < 0 || fd >= MAX_PROCESS_FILES || process->files[fd] == 0)
+    {
+        return -EBADF;
+    }
+
+    return process->files[fd];
+}
+
+static int process_clone_files(struct process *parent, struct process *child)
+{ // The child shares the open files of the parent.
+    int res = 0;
+    for (int i = 0; i < MAX_PROCESS_FILES; i++)
+    {
+        if (parent->files[i] == 0)
+        {
+            continue;
+        }
+
+        res = fref(parent->files[i]);
+        if (res < 0)
+        {
+            goto out;
+        }
+
+        child->files[i] = parent->files[i];
+    }
+
+out:
+    return res;
+}
+
+static void process_close_files(struct process *process)
+{
+    for (int i = 0; i < MAX_PROCESS_FILES; i++)
+    {
+        if (process->files[i] > 0)
+        {
+            fclose(process->files[i]);
+            process->files[i] = 0;
+        }
+    }
+}
+
 static int process_load_binary(const char *filename,
                                struct process *process)
-{ // Load the binary file.
+{ // Open the binary file, its pages are read when they are touched.
     int res = 0;
     int fd = fopen(filename, "r");
     if (fd <= 0)
@@ -47,23 +93,11 @@ static int process_load_binary(const char *filename,
     res = fstat(fd, &stat);
     if (res < 0)
     {
+        fclose(fd);
         goto out;
     }
 
-    void *program_data_ptr = kzalloc(stat.filesize);
-    if (program_data_ptr == NULL)
-    {
-        res = -ENOMEM;
-        goto out;
-    }
-
-    if (fread(fd, program_data_ptr, stat.filesize, 1) < 0)
-    {
-        res = -EIO;
-        goto out;
-    }
-
-    process->physical_pointer = program_data_ptr;
+    process->fd = fd;
     process->size = stat.filesize;
 out:
     return res;
@@ -81,18 +115,61 @@ out:
 static int process_map_binary(struct process *process)
 {
     int res = 0;
-    res = paging_map_virtual_memory(process->task->page_directory, (void *)PROGRAM_VIRTUAL_ADDRESS,
-                                    process->physical_pointer,
-                                    paging_align_address(process->physical_pointer + process->size),
-                                    PAGING_IS_PRESENT | PAGING_ACCESS_FROM_ALL | PAGING_IS_WRITEABLE);
+    struct process_region *region = process_region_add(process,
+                                                       PROGRAM_VIRTUAL_ADDRESS,
+                                                       PROGRAM_VIRTUAL_ADDRESS + (uint32_t)paging_align_address((void *)process->size),
+                                                       PROCESS_REGION_FILE,
+                                                       PROCESS_REGION_WRITEABLE);
+    if (IS_ERR(region))
+    {
+        res = PTR_ERR(region);
+        goto out;
+    }
+
+    res = process_region_set_file(region, process->fd, 0, process->size);
+    if (res < 0)
+    { // Not backed by the file, releasing the region must not close it.
+        region->type = PROCESS_REGION_ANONYMOUS;
+    }
+
 out:
     return res;
 }
 
+static int process_map_stack(struct process *process)
+{ // The stack sits at the top of the user window and grows down.
+    int res = 0;
+    struct process_region *region = process_region_add(process,
+                                                       PROGRAM_VIRTUAL_STACK_ADDRESS_END,
+                                                       PROGRAM_VIRTUAL_STACK_ADDRESS_START,
+                                                       PROCESS_REGION_ANONYMOUS,
+                                                       PROCESS_REGION_WRITEABLE | PROCESS_REGION_GROWS_DOWN);
+    if (IS_ERR(region))
+    {
+        res = PTR_ERR(region);
+    }
+
+    return res;
+}
+
 static int process_map_virtual_memory(struct process *process)
-{
+{ // Describe the user window, nothing is mapped until it is touched.
     int res = 0;
     res = process_map_binary(process);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    res = process_map_stack(process);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    // The heap is empty until the first brk.
+    process->heap_start = PROGRAM_VIRTUAL_ADDRESS + (uint32_t)paging_align_address((void *)process->size);
+    process->brk = process->heap_start;
 out:
     return res;
 }
@@ -104,7 +181,6 @@ int process_load_for_slot(const char *filename,
     int res = 0;
     struct task *task = NULL;
     struct process *tmp_process = NULL;
-    void *program_stack_ptr = NULL;
 
     if (get_process_by_id(slot))
     {
@@ -126,16 +202,8 @@ int process_load_for_slot(const char *filename,
         goto out;
     }
 
-    program_stack_ptr = kzalloc(USER_PROGRAM_STACK_SIZE);
-    if (program_stack_ptr == NULL)
-    {
-        res = -ENOMEM;
-        goto out;
-    }
-
     // Init process properties.
     strncpy(tmp_process->binary_file, filename, sizeof(tmp_process->binary_file));
-    tmp_process->stack_pointer = program_stack_ptr;
     tmp_process->id = slot;
 
     // Create a new task for the process.
@@ -162,9 +230,15 @@ out:
     {
         if (tmp_process != NULL && tmp_process->task)
         {
+            process_region_release_all(tmp_process);
             release_task(tmp_process->task);
         }
 
+        if (tmp_process != NULL && tmp_process->fd > 0)
+        {
+            fclose(tmp_process->fd);
+        }
+
         kfree(tmp_process);
     }
 
@@ -184,6 +258,314 @@ static int process_get_free_slot()
     return -ENOMEM;
 }
 
+int process_fork(struct process *parent, struct process **child)
+{ // The child shares the pages of the parent until one of them writes.
+    int res = 0;
+    struct task *task = NULL;
+    struct process *tmp_process = NULL;
+    int slot = process_get_free_slot();
+    if (slot < 0)
+    {
+        res = slot;
+        goto out;
+    }
+
+    tmp_process = kzalloc(sizeof(struct process));
+    if (tmp_process == NULL)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    process_init(tmp_process);
+    // The binary gets its own descriptor, so file positions are not shared.
+    res = process_load_binary(parent->binary_file, tmp_process);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    strncpy(tmp_process->binary_file, parent->binary_file, sizeof(tmp_process->binary_file));
+    tmp_process->id = slot;
+    tmp_process->heap_start = parent->heap_start;
+    tmp_process->brk = parent->brk;
+
+    task = make_new_task(tmp_process);
+    if (IS_ERR(task))
+    {
+        res = PTR_ERR(task);
+        goto out;
+    }
+
+    tmp_process->task = task;
+
+    // Resume where the parent made the call, but see 0 as the result.
+    memcpy(&task->registers, &parent->task->registers, sizeof(struct registers));
+    task->registers.eax = 0;
+
+    res = process_region_clone_all(parent, tmp_process);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    res = process_clone_files(parent, tmp_process);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    processes[slot] = tmp_process;
+    *child = tmp_process;
+    res = slot;
+
+out:
+    if (res < 0)
+    {
+        if (tmp_process != NULL && tmp_process->task)
+        {
+            process_region_release_all(tmp_process);
+            release_task(tmp_process->task);
+        }
+
+        if (tmp_process != NULL && tmp_process->fd > 0)
+        {
+            fclose(tmp_process->fd);
+        }
+
+        if (tmp_process != NULL)
+        {
+            process_close_files(tmp_process);
+        }
+
+        kfree(tmp_process);
+    }
+
+    return res;
+}
+
+int process_open(struct process *process, const char *filename, const char *mode)
+{
+    int res = -EMFILE;
+    for (int i = 0; i < MAX_PROCESS_FILES; i++)
+    {
+        if (process->files[i] == 0)
+        {
+            res = i;
+            break;
+        }
+    }
+
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    int file = fopen(filename, mode);
+    if (file <= 0)
+    {
+        res = -EIO;
+        goto out;
+    }
+
+    process->files[res] = file;
+out:
+    return res;
+}
+
+int process_close(struct process *process, int fd)
+{
+    int res = process_get_file(process, fd);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    process->files[fd] = 0;
+    res = fclose(res);
+out:
+    return res;
+}
+
+void *process_mmap(struct process *process, struct process_mmap_args *args)
+{
+    int res = 0;
+    uint32_t start = args->addr;
+    uint32_t length = (uint32_t)paging_align_address((void *)args->length);
+    int file = process_get_file(process, args->fd);
+    struct file_stat stat;
+    if (args->length == 0 || length == 0 || args->offset % PAGING_PAGE_SIZE ||
+        !(args->flags & (MAP_SHARED | MAP_PRIVATE)))
+    {
+        res = -EINVAL;
+        goto out;
+    }
+
+    // Files are read only, only private mappings can be written.
+    bool anonymous = args->flags & MAP_ANONYMOUS;
+    if (!anonymous && (args->prot & PROT_WRITE) && (args->flags & MAP_SHARED))
+    {
+        res = -EROFS;
+        goto out;
+    }
+
+    if (!anonymous && file < 0)
+    {
+        res = file;
+        goto out;
+    }
+
+    res = anonymous ? 0 : fstat(file, &stat);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    if (!(args->flags & MAP_FIXED))
+    {
+        start = process_region_find_free(process, length);
+        if (start == 0)
+        {
+            res = -ENOMEM;
+            goto out;
+        }
+    }
+
+    uint8_t type = anonymous ? PROCESS_REGION_ANONYMOUS : PROCESS_REGION_FILE;
+    uint8_t flags = (args->prot & PROT_WRITE) ? PROCESS_REGION_WRITEABLE : 0;
+    struct process_region *region = process_region_add(process, start, start + length, type, flags);
+    if (IS_ERR(region))
+    {
+        res = PTR_ERR(region);
+        goto out;
+    }
+
+    if (anonymous)
+    {
+        goto out;
+    }
+
+    uint32_t file_size = (args->offset < stat.filesize) ? stat.filesize - args->offset : 0;
+    res = process_region_set_file(region, file, args->offset, (file_size < length) ? file_size : length);
+    if (res < 0)
+    {
+        region->type = PROCESS_REGION_ANONYMOUS;
+        process_region_remove(process, region);
+        goto out;
+    }
+
+out:
+    if (res < 0)
+    {
+        return ERR_PTR(res);
+    }
+
+    return (void *)start;
+}
+
+int process_munmap(struct process *process, void *address, uint32_t length)
+{
+    uint32_t start = (uint32_t)address;
+    uint32_t end = (uint32_t)paging_align_address((void *)(start + length));
+    if (length == 0 || end < start)
+    {
+        return -EINVAL;
+    }
+
+    return process_region_unmap(process, start, end);
+}
+
+static int process_set_brk(struct process *process, uint32_t brk)
+{ // The heap is one anonymous region, from the start of the heap to the break.
+    int res = 0;
+    uint32_t end = (uint32_t)paging_align_address((void *)brk);
+    struct process_region *heap = process_region_find(process, process->heap_start);
+    if (brk < process->heap_start || end < brk)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    if (heap == NULL && end > process->heap_start)
+    {
+        heap = process_region_add(process, process->heap_start, end, PROCESS_REGION_ANONYMOUS, PROCESS_REGION_WRITEABLE);
+        res = IS_ERR(heap) ? -ENOMEM : 0;
+    }
+    else if (heap != NULL && end == process->heap_start)
+    {
+        process_region_remove(process, heap);
+    }
+    else if (heap != NULL)
+    {
+        res = process_region_grow(process, heap, end);
+    }
+
+    if (res == 0)
+    {
+        process->brk = brk;
+    }
+
+out:
+    return res;
+}
+
+void *process_brk(struct process *process, void *address)
+{
+    if (address != NULL)
+    { // Failing leaves the break where it was, which is what gets returned.
+        process_set_brk(process, (uint32_t)address);
+    }
+
+    return (void *)process->brk;
+}
+
+void *process_sbrk(struct process *process, int increment)
+{
+    uint32_t brk = process->brk;
+    int res = process_set_brk(process, brk + increment);
+    if (res < 0)
+    {
+        return ERR_PTR(res);
+    }
+
+    return (void *)brk;
+}
+
+void process_terminate(struct process *process)
+{
+    if (processes[process->id] == process)
+    {
+        processes[process->id] = NULL;
+    }
+
+    if (current_process == process)
+    {
+        current_process = NULL;
+    }
+
+    // Releasing the directory of the running task switches to the kernel one.
+    process_region_release_all(process);
+    release_task(process->task);
+    if (process->fd > 0)
+    {
+        fclose(process->fd);
+    }
+
+    process_close_files(process);
+    kfree(process);
+}
+
+int process_handle_page_fault(uint32_t address, uint32_t error_code)
+{
+    struct task *task = get_current_task();
+    if (task == NULL || task->proc == NULL)
+    {
+        return -EFAULT;
+    }
+
+    return process_region_handle_fault(task->proc, address, error_code);
+}
+
 int load_process(const char *filename, struct process **process)
 {
     int res = 0;
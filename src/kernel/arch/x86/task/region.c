@@ -0,0 +1,680 @@
+#include <task/region.h>
+#include <task/process.h>
+#include <task/task.h>
+#include <memory/paging.h>
+#include <memory/frame.h>
+#include <memory/kheap.h>
+#include <fs/file.h>
+#include <fs/page_cache.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+
+static bool process_region_is_valid_range(uint32_t start, uint32_t end)
+{
+    return (start % PAGING_PAGE_SIZE) == 0 &&
+           (end % PAGING_PAGE_SIZE) == 0 &&
+           start < end &&
+           start >= USER_SPACE_START &&
+           end <= USER_SPACE_END;
+}
+
+static int process_region_height(struct process_region *node)
+{
+    return (node == NULL) ? 0 : node->height;
+}
+
+static void process_region_update_height(struct process_region *node)
+{
+    int left = process_region_height(node->left);
+    int right = process_region_height(node->right);
+    node->height = ((left > right) ? left : right) + 1;
+}
+
+static struct process_region *process_region_rotate_right(struct process_region *node)
+{
+    struct process_region *left = node->left;
+    node->left = left->right;
+    left->right = node;
+    process_region_update_height(node);
+    process_region_update_height(left);
+    return left;
+}
+
+static struct process_region *process_region_rotate_left(struct process_region *node)
+{
+    struct process_region *right = node->right;
+    node->right = right->left;
+    right->left = node;
+    process_region_update_height(node);
+    process_region_update_height(right);
+    return right;
+}
+
+static struct process_region *process_region_balance(struct process_region *node)
+{ // AVL, the heights of the two subtrees differ by one at most.
+    process_region_update_height(node);
+    int balance = process_region_height(node->left) - process_region_height(node->right);
+    if (balance > 1)
+    {
+        if (process_region_height(node->left->left) < process_region_height(node->left->right))
+        {
+            node->left = process_region_rotate_left(node->left);
+        }
+
+        return process_region_rotate_right(node);
+    }
+
+    if (balance < -1)
+    {
+        if (process_region_height(node->right->right) < process_region_height(node->right->left))
+        {
+            node->right = process_region_rotate_right(node->right);
+        }
+
+        return process_region_rotate_left(node);
+    }
+
+    return node;
+}
+
+static struct process_region *process_region_tree_insert(struct process_region *node, struct process_region *region)
+{
+    if (node == NULL)
+    {
+        region->left = NULL;
+        region->right = NULL;
+        region->height = 1;
+        return region;
+    }
+
+    if (region->start < node->start)
+    {
+        node->left = process_region_tree_insert(node->left, region);
+    }
+    else
+    {
+        node->right = process_region_tree_insert(node->right, region);
+    }
+
+    return process_region_balance(node);
+}
+
+static struct process_region *process_region_tree_remove_min(struct process_region *node)
+{ // Unlink the leftmost region of the subtree, which the caller already knows.
+    if (node->left == NULL)
+    {
+        return node->right;
+    }
+
+    node->left = process_region_tree_remove_min(node->left);
+    return process_region_balance(node);
+}
+
+static struct process_region *process_region_tree_remove(struct process_region *node, struct process_region *region)
+{
+    if (node == NULL)
+    {
+        return NULL;
+    }
+
+    if (region->start < node->start)
+    {
+        node->left = process_region_tree_remove(node->left, region);
+        return process_region_balance(node);
+    }
+
+    if (region->start > node->start)
+    {
+        node->right = process_region_tree_remove(node->right, region);
+        return process_region_balance(node);
+    }
+
+    if (node->left == NULL || node->right == NULL)
+    {
+        return (node->left != NULL) ? node->left : node->right;
+    }
+
+    // The successor in the list is the leftmost region of the right subtree.
+    struct process_region *successor = region->next;
+    successor->right = process_region_tree_remove_min(node->right);
+    successor->left = node->left;
+    return process_region_balance(successor);
+}
+
+static struct process_region *process_region_find_last_before(struct process *process, uint32_t address)
+{ // Region with the highest start below `address`.
+    struct process_region *last = NULL;
+    struct process_region *node = process->region_tree;
+    while (node != NULL)
+    {
+        if (node->start < address)
+        {
+            last = node;
+            node = node->right;
+        }
+        else
+        {
+            node = node->left;
+        }
+    }
+
+    return last;
+}
+
+struct process_region *process_region_add(struct process *process,
+                                          uint32_t start,
+                                          uint32_t end,
+                                          uint8_t type,
+                                          uint8_t flags)
+{
+    int res = 0;
+    struct process_region *region = NULL;
+    if (!process_region_is_valid_range(start, end))
+    {
+        res = -EINVAL;
+        goto out;
+    }
+
+    // Regions never overlap, the last region starting before the end of the
+    // new one has to end before it starts. It is also the one to link after.
+    struct process_region *prev = process_region_find_last_before(process, end);
+    if (prev != NULL && prev->end > start)
+    {
+        res = -EEXIST;
+        goto out;
+    }
+
+    region = kzalloc(sizeof(struct process_region));
+    if (region == NULL)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    region->start = start;
+    region->end = end;
+    region->type = type;
+    region->flags = flags;
+    region->prev = prev;
+    region->next = (prev != NULL) ? prev->next : process->regions;
+    if (region->next != NULL)
+    {
+        region->next->prev = region;
+    }
+
+    if (prev != NULL)
+    {
+        prev->next = region;
+    }
+    else
+    {
+        process->regions = region;
+    }
+
+    process->region_tree = process_region_tree_insert(process->region_tree, region);
+
+out:
+    if (res < 0)
+    {
+        return ERR_PTR(res);
+    }
+
+    return region;
+}
+
+int process_region_set_file(struct process_region *region, int fd, uint32_t offset, uint32_t size)
+{
+    int res = fref(fd);
+    if (res < 0)
+    {
+        return res;
+    }
+
+    region->fd = fd;
+    region->file_offset = offset;
+    region->file_size = size;
+    return 0;
+}
+
+struct process_region *process_region_find(struct process *process, uint32_t address)
+{
+    struct process_region *node = process->region_tree;
+    while (node != NULL)
+    {
+        if (address < node->start)
+        {
+            node = node->left;
+        }
+        else if (address >= node->end)
+        {
+            node = node->right;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    return node;
+}
+
+static uint32_t process_region_get_reserved_start(struct process_region *region)
+{ // A stack keeps the room it may grow into, and the guard page below it.
+    uint32_t reserved = USER_PROGRAM_STACK_MAX_SIZE + PAGING_PAGE_SIZE;
+    if (!(region->flags & PROCESS_REGION_GROWS_DOWN))
+    {
+        return region->start;
+    }
+
+    return (region->end - USER_SPACE_START > reserved) ? region->end - reserved : USER_SPACE_START;
+}
+
+uint32_t process_region_find_free(struct process *process, uint32_t size)
+{
+    uint32_t start = PROCESS_REGION_MMAP_START;
+    for (struct process_region *region = process->regions; region != NULL; region = region->next)
+    {
+        if (region->end <= start)
+        {
+            continue;
+        }
+
+        uint32_t reserved_start = process_region_get_reserved_start(region);
+        if (reserved_start >= start && reserved_start - start >= size)
+        {
+            break;
+        }
+
+        start = region->end;
+    }
+
+    if (start > USER_SPACE_END || USER_SPACE_END - start < size)
+    {
+        return 0;
+    }
+
+    return start;
+}
+
+static void process_region_unmap_pages(struct process *process, uint32_t start, uint32_t end)
+{ // Give back the frames of the pages that were touched.
+    struct paging_4GB_chunk *directory = process->task->page_directory;
+    for (uint32_t page = start; page < end; page += PAGING_PAGE_SIZE)
+    {
+        uint32_t entry = paging_get_entry_of_address(directory, (void *)page);
+        if (entry & PAGING_IS_PRESENT)
+        {
+            paging_set_entry_for_virtual_address(directory, (void *)page, 0);
+            frame_free((void *)(entry & 0xFFFFF000));
+        }
+    }
+}
+
+static void process_region_release(struct process *process, struct process_region *region)
+{
+    process_region_unmap_pages(process, region->start, region->end);
+    if (region->type == PROCESS_REGION_FILE)
+    {
+        fclose(region->fd);
+    }
+
+    kfree(region);
+}
+
+void process_region_remove(struct process *process, struct process_region *region)
+{
+    process->region_tree = process_region_tree_remove(process->region_tree, region);
+    if (region->prev != NULL)
+    {
+        region->prev->next = region->next;
+    }
+    else
+    {
+        process->regions = region->next;
+    }
+
+    if (region->next != NULL)
+    {
+        region->next->prev = region->prev;
+    }
+
+    process_region_release(process, region);
+}
+
+int process_region_grow(struct process *process, struct process_region *region, uint32_t end)
+{
+    if (!process_region_is_valid_range(region->start, end) ||
+        (region->next != NULL && process_region_get_reserved_start(region->next) < end))
+    { // Growing into the next region, or into the room a stack keeps.
+        return -ENOMEM;
+    }
+
+    if (end < region->end)
+    {
+        process_region_unmap_pages(process, end, region->end);
+    }
+
+    region->end = end;
+    return 0;
+}
+
+static void process_region_cut_front(struct process *process, struct process_region *region, uint32_t start)
+{ // The start is the key of the tree, the region goes back in at its new place.
+    uint32_t cut = start - region->start;
+    process_region_unmap_pages(process, region->start, start);
+    process->region_tree = process_region_tree_remove(process->region_tree, region);
+    region->start = start;
+    region->file_offset += cut;
+    region->file_size = (region->file_size > cut) ? region->file_size - cut : 0;
+    process->region_tree = process_region_tree_insert(process->region_tree, region);
+}
+
+static int process_region_split(struct process *process, struct process_region *region, uint32_t address)
+{ // Cut the region in two at `address`, the upper part becomes a new region.
+    int res = 0;
+    uint32_t end = region->end;
+    region->end = address;
+    struct process_region *upper = process_region_add(process, address, end, region->type, region->flags);
+    if (IS_ERR(upper))
+    {
+        region->end = end;
+        res = PTR_ERR(upper);
+        goto out;
+    }
+
+    if (region->type == PROCESS_REGION_FILE)
+    {
+        uint32_t cut = address - region->start;
+        uint32_t file_size = (region->file_size > cut) ? region->file_size - cut : 0;
+        res = process_region_set_file(upper, region->fd, region->file_offset + cut, file_size);
+        if (res < 0)
+        {
+            upper->type = PROCESS_REGION_ANONYMOUS;
+            process_region_remove(process, upper);
+            region->end = end;
+            goto out;
+        }
+
+        region->file_size = (region->file_size < cut) ? region->file_size : cut;
+    }
+
+out:
+    return res;
+}
+
+int process_region_unmap(struct process *process, uint32_t start, uint32_t end)
+{
+    int res = 0;
+    if (!process_region_is_valid_range(start, end))
+    {
+        res = -EINVAL;
+        goto out;
+    }
+
+    struct process_region *region = process_region_find_last_before(process, start + 1);
+    if (region == NULL || region->end <= start)
+    {
+        region = (region != NULL) ? region->next : process->regions;
+    }
+
+    while (region != NULL && region->start < end)
+    {
+        struct process_region *next = region->next;
+        if (region->start < start)
+        { // Keep the part below the range, the rest is handled as a region of its own.
+            res = process_region_split(process, region, start);
+            if (res < 0)
+            {
+                goto out;
+            }
+
+            next = region->next;
+        }
+        else if (region->end > end)
+        {
+            process_region_cut_front(process, region, end);
+        }
+        else
+        {
+            process_region_remove(process, region);
+        }
+
+        region = next;
+    }
+
+out:
+    return res;
+}
+
+void process_region_release_all(struct process *process)
+{
+    struct process_region *region = process->regions;
+    while (region != NULL)
+    {
+        struct process_region *next = region->next;
+        process_region_release(process, region);
+        region = next;
+    }
+
+    process->regions = NULL;
+    process->region_tree = NULL;
+}
+
+static int process_region_share_pages(struct process *parent,
+                                     struct process *child,
+                                     struct process_region *region)
+{
+    int res = 0;
+    struct paging_4GB_chunk *parent_directory = parent->task->page_directory;
+    struct paging_4GB_chunk *child_directory = child->task->page_directory;
+    for (uint32_t page = region->start; page < region->end; page += PAGING_PAGE_SIZE)
+    {
+        uint32_t entry = paging_get_entry_of_address(parent_directory, (void *)page);
+        if (!(entry & PAGING_IS_PRESENT))
+        { // Not touched yet, the child faults it in on its own.
+            continue;
+        }
+
+        if (entry & PAGING_IS_WRITEABLE)
+        {
+            entry = (entry & ~PAGING_IS_WRITEABLE) | PAGING_IS_COPY_ON_WRITE;
+            res = paging_set_entry_for_virtual_address(parent_directory, (void *)page, entry);
+            if (res < 0)
+            {
+                break;
+            }
+        }
+
+        res = frame_ref((void *)(entry & 0xFFFFF000));
+        if (res < 0)
+        {
+            break;
+        }
+
+        res = paging_set_entry_for_virtual_address(child_directory, (void *)page, entry);
+        if (res < 0)
+        {
+            frame_free((void *)(entry & 0xFFFFF000));
+            break;
+        }
+    }
+
+    return res;
+}
+
+int process_region_clone_all(struct process *parent, struct process *child)
+{
+    int res = 0;
+    for (struct process_region *region = parent->regions; region != NULL; region = region->next)
+    {
+        struct process_region *copy = process_region_add(child, region->start, region->end, region->type, region->flags);
+        if (IS_ERR(copy))
+        {
+            res = PTR_ERR(copy);
+            break;
+        }
+
+        if (region->type == PROCESS_REGION_FILE)
+        { // The binary is opened again for the child, other files are shared.
+            int fd = (region->fd == parent->fd) ? child->fd : region->fd;
+            res = process_region_set_file(copy, fd, region->file_offset, region->file_size);
+            if (res < 0)
+            {
+                // Not a file region yet, nothing to close on release.
+                copy->type = PROCESS_REGION_ANONYMOUS;
+                break;
+            }
+        }
+
+        res = process_region_share_pages(parent, child, region);
+        if (res < 0)
+        {
+            break;
+        }
+    }
+
+    return res;
+}
+
+static void *process_region_get_frame(struct process_region *region, uint32_t page)
+{ // Frame for a page touched for the first time, file pages come from the page cache.
+    uint32_t offset = page - region->start;
+    if (region->type == PROCESS_REGION_FILE && offset < region->file_size)
+    {
+        return page_cache_get(region->fd, region->file_offset + offset);
+    }
+
+    void *frame = frame_alloc_zeroed();
+    if (frame == NULL && page_cache_shrink() > 0)
+    { // Memory is short, cached pages nobody maps can go.
+        frame = frame_alloc_zeroed();
+    }
+
+    return (frame == NULL) ? ERR_PTR(-ENOMEM) : frame;
+}
+
+static int process_region_copy_on_write(struct process *process, uint32_t page, uint32_t entry)
+{ // Write to a page shared since a fork, the last user keeps the frame.
+    int res = 0;
+    struct paging_4GB_chunk *directory = process->task->page_directory;
+    void *shared_frame = (void *)(entry & 0xFFFFF000);
+    uint32_t flags = (entry & 0xFFF & ~PAGING_IS_COPY_ON_WRITE) | PAGING_IS_WRITEABLE;
+    if (frame_get_refcount(shared_frame) == 1)
+    {
+        res = paging_set_entry_for_virtual_address(directory, (void *)page, (uint32_t)shared_frame | flags);
+        goto out;
+    }
+
+    void *frame = frame_alloc();
+    if (frame == NULL)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    memcpy(frame, shared_frame, PAGING_PAGE_SIZE);
+    res = paging_set_entry_for_virtual_address(directory, (void *)page, (uint32_t)frame | flags);
+    if (res < 0)
+    {
+        frame_free(frame);
+        goto out;
+    }
+
+    frame_free(shared_frame);
+
+out:
+    return res;
+}
+
+static struct process_region *process_region_grow_stack(struct process *process, uint32_t address)
+{ // Extend the stack above `address` down to it, if that stays in its limit
+  // and leaves a guard page above the region below.
+    uint32_t page = address & ~(PAGING_PAGE_SIZE - 1);
+    struct process_region *below = process_region_find_last_before(process, address);
+    struct process_region *stack = (below != NULL) ? below->next : process->regions;
+    if (stack == NULL || !(stack->flags & PROCESS_REGION_GROWS_DOWN))
+    {
+        return NULL;
+    }
+
+    if (page < process_region_get_reserved_start(stack) + PAGING_PAGE_SIZE ||
+        (below != NULL && below->end + PAGING_PAGE_SIZE > page))
+    {
+        return NULL;
+    }
+
+    // The start is the key of the tree, the region goes back in at its new place.
+    process->region_tree = process_region_tree_remove(process->region_tree, stack);
+    stack->start = page;
+    process->region_tree = process_region_tree_insert(process->region_tree, stack);
+    return stack;
+}
+
+int process_region_handle_fault(struct process *process, uint32_t address, uint32_t error_code)
+{
+    int res = 0;
+    void *frame = NULL;
+    struct process_region *region = process_region_find(process, address);
+    if (region == NULL)
+    {
+        region = process_region_grow_stack(process, address);
+    }
+
+    if (region == NULL)
+    {
+        res = -EFAULT;
+        goto out;
+    }
+
+    if ((error_code & PAGE_FAULT_WRITE) && !(region->flags & PROCESS_REGION_WRITEABLE))
+    {
+        res = -EFAULT;
+        goto out;
+    }
+
+    uint32_t page = address & ~(PAGING_PAGE_SIZE - 1);
+    if (error_code & PAGE_FAULT_PRESENT)
+    { // Only a write to a copy on write page can be resolved.
+        uint32_t entry = paging_get_entry_of_address(process->task->page_directory, (void *)page);
+        if (!(error_code & PAGE_FAULT_WRITE) || !(entry & PAGING_IS_COPY_ON_WRITE))
+        {
+            res = -EFAULT;
+            goto out;
+        }
+
+        res = process_region_copy_on_write(process, page, entry);
+        goto out;
+    }
+
+    frame = process_region_get_frame(region, page);
+    if (IS_ERR(frame))
+    {
+        res = PTR_ERR(frame);
+        frame = NULL;
+        goto out;
+    }
+
+    // File pages may be shared with the page cache, they are copied on write.
+    int flags = PAGING_IS_PRESENT | PAGING_ACCESS_FROM_ALL;
+    if (region->flags & PROCESS_REGION_WRITEABLE)
+    {
+        flags |= (region->type == PROCESS_REGION_FILE) ? PAGING_IS_COPY_ON_WRITE : PAGING_IS_WRITEABLE;
+    }
+
+    res = paging_map_page(process->task->page_directory, (void *)page, frame, flags);
+    if (res == 0 && (error_code & PAGE_FAULT_WRITE) && (flags & PAGING_IS_COPY_ON_WRITE))
+    { // Copy right away, the write would only fault again.
+        uint32_t entry = (uint32_t)frame | flags;
+        frame = NULL;
+        res = process_region_copy_on_write(process, page, entry);
+    }
+
+out:
+    if (res < 0 && frame != NULL)
+    {
+        frame_free(frame);
+    }
+
+    return res;
+}
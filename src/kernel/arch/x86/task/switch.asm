@@ -5,6 +5,9 @@ global restore_general_purpose_registers
 global task_return
 global load_user_data_segment_registers
 global load_kernel_data_segment_registers
+global task_exit_to_kernel
+
+extern kernel_idle
 
 ; C prototype: void task_return(struct registers* regs);
 task_return:
@@ -85,4 +88,15 @@ load_kernel_data_segment_registers:
     mov es, ax
     mov gs, ax
     mov fs, ax
-    ret
\ No newline at end of file
+    ret
+
+; C prototype: void task_exit_to_kernel();
+; Leave an interrupt of a task that will never run again. The next switch
+; from user mode reuses the kernel stack of the interrupt (esp0 in the TSS),
+; so the idle loop continues on the boot stack, unused once a task runs.
+
+task_exit_to_kernel:
+    mov ebp, 0x00200000 ; Top of the boot stack, see start.asm.
+    mov esp, ebp
+    sti                 ; Interrupt gates cleared IF, the idle loop needs them.
+    call kernel_idle
@@ -6,6 +6,7 @@
 #include <task/process.h>
 #include <panic.h>
 #include <interrupt.h>
+#include <stdbool.h>
 
 struct task *current_task = NULL;
 
@@ -73,8 +74,8 @@ static int task_init(struct task *task, struct process *proc)
     int res = 0;
     memset(task, 0, sizeof(struct task));
 
-    // Map the entire 4GB address space to its self.
-    task->page_directory = make_new_4GB_virtual_memory_address_space(PAGING_IS_PRESENT | PAGING_ACCESS_FROM_ALL);
+    // Share the kernel part of the address space, the user part is mapped later.
+    task->page_directory = make_new_user_virtual_memory_address_space();
     if (task->page_directory == NULL)
     {
         res = -EIO;
@@ -181,62 +182,137 @@ void task_save_state(struct task *task, struct interrupt_frame *frame)
     task->registers.esi = frame->esi;
 }
 
-int copy_from_user(struct task *task, void *user_ptr, void *to, int size)
-{
-    int res = 0;
+static void *task_get_user_page(struct task *task, uint32_t page, bool write)
+{ // Kernel address of a user page, faulted in the way the task would.
+    if (task->proc == NULL)
+    {
+        return ERR_PTR(-EFAULT);
+    }
 
-    if (size >= PAGING_PAGE_SIZE)
+    uint32_t entry = paging_get_entry_of_address(task->page_directory, (void *)page);
+    if (!(entry & PAGING_IS_PRESENT) || (write && !(entry & PAGING_IS_WRITEABLE)))
     {
-        res = -EINVAL;
-        goto out;
+        uint32_t error_code = PAGE_FAULT_USER;
+        error_code |= (entry & PAGING_IS_PRESENT) ? PAGE_FAULT_PRESENT : 0;
+        error_code |= write ? PAGE_FAULT_WRITE : 0;
+        int res = process_region_handle_fault(task->proc, page, error_code);
+        if (res < 0)
+        {
+            return ERR_PTR(res);
+        }
+
+        entry = paging_get_entry_of_address(task->page_directory, (void *)page);
     }
 
-    // Make a pointer in kernel page.
-    char *tmp = kzalloc(size);
+    // Frames all sit below the user window, where the kernel maps them 1:1.
+    return (void *)(entry & 0xFFFFF000);
+}
+
+static bool task_check_user_range(void *user_ptr, size_t size)
+{
+    uint32_t start = (uint32_t)user_ptr;
+    return start >= USER_SPACE_START && start <= USER_SPACE_END && size <= USER_SPACE_END - start;
+}
 
-    if (tmp == NULL)
+static int task_copy_user(struct task *task, void *user_ptr, void *buffer, size_t size, bool write)
+{ // Copy page by page through the frames, the task directory is never loaded.
+    int res = 0;
+    uint32_t address = (uint32_t)user_ptr;
+    char *kernel_buffer = buffer;
+    if (!task_check_user_range(user_ptr, size))
     {
-        res = -ENOMEM;
+        res = -EFAULT;
         goto out;
     }
 
-    struct paging_4GB_chunk* page_structure = task->page_directory;
-
-    // Get the paging entry from the task for that particular page.
-    uint32_t old_entry = paging_get_entry_of_address(page_structure, tmp);
+    while (size > 0)
+    {
+        uint32_t offset = address % PAGING_PAGE_SIZE;
+        size_t chunk = PAGING_PAGE_SIZE - offset;
+        if (chunk > size)
+        {
+            chunk = size;
+        }
+
+        char *page = task_get_user_page(task, address - offset, write);
+        if (IS_ERR(page))
+        {
+            res = PTR_ERR(page);
+            goto out;
+        }
+
+        if (write)
+        {
+            memcpy(page + offset, kernel_buffer, chunk);
+        }
+        else
+        {
+            memcpy(kernel_buffer, page + offset, chunk);
+        }
+
+        address += chunk;
+        kernel_buffer += chunk;
+        size -= chunk;
+    }
 
-    // Map the virtual address of temp in the task page to physical memory point to the same address.
-    // So when the task page is loaded, It will make temp become valid memory.
-    paging_map_page(page_structure,
-                    tmp,
-                    tmp,
-                    PAGING_IS_WRITEABLE | PAGING_IS_PRESENT | PAGING_ACCESS_FROM_ALL);
+out:
+    return res;
+}
 
-    // Switch to task page and we can see the memory.
-    switch_to_page(page_structure);
+int copy_from_user(struct task *task, void *user_ptr, void *to, size_t size)
+{
+    return task_copy_user(task, user_ptr, to, size, false);
+}
 
-    // Copy data to temp at virtual memory.
-    strncpy(tmp, user_ptr, size);
+int copy_to_user(struct task *task, void *from, void *user_ptr, size_t size)
+{
+    return task_copy_user(task, user_ptr, from, size, true);
+}
 
-    // Switch back to kernel page.
-    switch_to_kernel_page();
+int strncpy_from_user(struct task *task, void *user_ptr, char *to, size_t max)
+{
+    int res = 0;
+    uint32_t address = (uint32_t)user_ptr;
+    if (max == 0 || !task_check_user_range(user_ptr, 1))
+    {
+        res = -EFAULT;
+        goto out;
+    }
 
-    // We need to restore the old task page back to the old entry for that address,
-    // because maybe it was pointing somewhere important. So we have to send it back
-    // to the old entry to avoid user processes pointing to this point forever.
-    res = paging_set_entry_for_virtual_address(page_structure, tmp, old_entry);
-    if (res < 0)
+    size_t total = 0;
+    while (total < max && address < USER_SPACE_END)
     {
-        res = -EIO;
-        goto free;
+        uint32_t offset = address % PAGING_PAGE_SIZE;
+        char *page = task_get_user_page(task, address - offset, false);
+        if (IS_ERR(page))
+        {
+            res = PTR_ERR(page);
+            goto out;
+        }
+
+        for (; offset < PAGING_PAGE_SIZE && total < max; offset++, address++)
+        {
+            to[total] = page[offset];
+            if (to[total] == '\0')
+            {
+                res = total;
+                goto out;
+            }
+
+            total++;
+        }
     }
 
-    // Copy data to output pointer.
-    strncpy(to, tmp, size);
+    if (total < max)
+    { // Ran off the end of the user window.
+        res = -EFAULT;
+        goto out;
+    }
 
-free:
-    kfree(tmp);
+    // No terminator within `max` bytes, the string is cut.
+    to[max - 1] = '\0';
+    res = max - 1;
 
 out:
     return res;
-}
\ No newline at end of file
+}
@@ -0,0 +1,58 @@
+#include <task/wait_queue.h>
+#include <task/task.h>
+#include <interrupt.h>
+#include <errno.h>
+
+void wait_queue_init(struct wait_queue *queue)
+{
+    queue->head = NULL;
+}
+
+static void wait_queue_remove(struct wait_queue *queue, struct wait_queue_entry *entry)
+{
+    struct wait_queue_entry **link = &queue->head;
+    while (*link != NULL && *link != entry)
+    {
+        link = &(*link)->next;
+    }
+
+    if (*link != NULL)
+    {
+        *link = entry->next;
+    }
+}
+
+int wait_queue_wait(struct wait_queue *queue, int max_interrupts)
+{ // The entry lives on the stack of the waiting task, it is off the queue
+  // once this returns.
+    struct wait_queue_entry entry = {
+        .task = get_current_task(),
+        .woken = false,
+        .next = queue->head};
+    queue->head = &entry;
+
+    for (int i = 0; i < max_interrupts && !entry.woken; i++)
+    {
+        wait_for_interrupt();
+    }
+
+    if (!entry.woken)
+    {
+        wait_queue_remove(queue, &entry);
+        return -ETIMEDOUT;
+    }
+
+    return 0;
+}
+
+void wait_queue_wake_all(struct wait_queue *queue)
+{
+    struct wait_queue_entry *entry = queue->head;
+    queue->head = NULL;
+    while (entry != NULL)
+    { // Read the link first, the woken task may drop its entry right away.
+        struct wait_queue_entry *next = entry->next;
+        entry->woken = true;
+        entry = next;
+    }
+}
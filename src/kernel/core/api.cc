@@ -1,9 +1,121 @@
 #include <api.hh>
+#include <memory.hh>
+
+extern "C"
+{
+#include <errno.h>
+#include <memory/kheap.h>
+#include <task/process.h>
+#include <task/task.h>
+}
 
 namespace lava
 {
+    static struct process *get_calling_process()
+    {
+        struct task *task = get_current_task();
+        return (task == nullptr) ? nullptr : task->proc;
+    }
+
     void *sys_zero(const sys_args &)
     {
         return nullptr;
     }
+
+    void *sys_fork(const sys_args &)
+    {
+        struct process *child = nullptr;
+        struct process *process = get_calling_process();
+        if (process == nullptr)
+        {
+            return (void *)-1;
+        }
+
+        int pid = process_fork(process, &child);
+        return (void *)((pid < 0) ? -1 : pid);
+    }
+
+    void *sys_open(const sys_args &args)
+    {
+        char path[FILESYSTEM_MAX_PATH_LENGTH];
+        char mode[4];
+        struct process *process = get_calling_process();
+        if (process == nullptr ||
+            strncpy_from_user(process->task, (void *)args.get_arg(0), path, sizeof(path)) < 0 ||
+            strncpy_from_user(process->task, (void *)args.get_arg(1), mode, sizeof(mode)) < 0)
+        {
+            return (void *)-1;
+        }
+
+        int fd = process_open(process, path, mode);
+        return (void *)((fd < 0) ? -1 : fd);
+    }
+
+    void *sys_close(const sys_args &args)
+    {
+        struct process *process = get_calling_process();
+        if (process == nullptr || process_close(process, (int)args.get_arg(0)) < 0)
+        {
+            return (void *)-1;
+        }
+
+        return nullptr;
+    }
+
+    void *sys_brk(const sys_args &args)
+    {
+        struct process *process = get_calling_process();
+        if (process == nullptr)
+        {
+            return nullptr;
+        }
+
+        return process_brk(process, (void *)args.get_arg(0));
+    }
+
+    void *sys_sbrk(const sys_args &args)
+    {
+        struct process *process = get_calling_process();
+        if (process == nullptr)
+        {
+            return (void *)-1;
+        }
+
+        void *address = process_sbrk(process, (int)args.get_arg(0));
+        return IS_ERR(address) ? (void *)-1 : address;
+    }
+
+    void *sys_mmap(const sys_args &args)
+    {
+        struct process_mmap_args mmap;
+        struct process *process = get_calling_process();
+        if (process == nullptr ||
+            copy_from_user(process->task, (void *)args.get_arg(0), &mmap, sizeof(mmap)) < 0)
+        {
+            return (void *)-1;
+        }
+
+        void *address = process_mmap(process, &mmap);
+        return IS_ERR(address) ? (void *)-1 : address;
+    }
+
+    void *sys_munmap(const sys_args &args)
+    {
+        struct process *process = get_calling_process();
+        if (process == nullptr)
+        {
+            return (void *)-1;
+        }
+
+        int res = process_munmap(process, (void *)args.get_arg(0), args.get_arg(1));
+        return (void *)((res < 0) ? -1 : 0);
+    }
+
+    void *sys_heap_stats(const sys_args &)
+    {
+        kheap_stats stats;
+        kernel_heap::print_stats();
+        kheap_get_stats(&stats);
+        return (void *)stats.bytes_in_use;
+    }
 }
\ No newline at end of file
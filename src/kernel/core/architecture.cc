@@ -11,6 +11,7 @@
 extern "C"
 {
 #include <string.h>
+#include <disk/ide_dma.h>
 }
 
 namespace lava
@@ -65,6 +66,13 @@ namespace lava
 
         // Test process.
         proc::get_instance().load_proc("/loop.bin");
+
+        // The file system and the first process were read through DMA,
+        // part of it with the drive polled, DMA has to have survived both.
+        if (ide_dma_has_failed())
+        {
+            cout << "Disk DMA failed during boot, the disk is using PIO." << endl;
+        }
     }
 
     arch &arch::get_instance()
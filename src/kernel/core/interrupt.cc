@@ -3,13 +3,16 @@
 extern "C"
 {
 #include <interrupt.h>
+#include <disk/disk.h>
 }
 
 namespace lava
 {
     void interrupt::initialize()
-    { // Initialize the interrupt descriptor table.
+    { // Initialize the interrupt descriptor table. The disk was polled so
+      // far, its interrupt has a handler from here on.
         init_interrupt_descriptor_table();
+        disk_enable_interrupts();
     }
 
     interrupt &interrupt::get_instance()
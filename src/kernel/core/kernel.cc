@@ -1,6 +1,7 @@
 #include <kernel.hh>
 #include <iostream.hh>
 #include <architecture.hh>
+#include <memory.hh>
 
 extern "C"
 {
@@ -8,8 +9,14 @@ extern "C"
     {
         lava::cout << lava::ostream::color::green << "Welcome to Larva OS." << lava::endl;
         lava::arch::get_instance().initialize();
+        kernel_idle();
+    }
+
+    void kernel_idle()
+    {
         while (1)
-        {
+        { // Nothing else to do, get page frames ready for later.
+            lava::kernel_heap::refill_zeroed_frames();
         }
     }
 }
@@ -1,7 +1,10 @@
 #include <memory.hh>
+#include <iostream.hh>
 extern "C"
 {
 #include <memory/kheap.h>
+#include <memory/slab.h>
+#include <memory/frame.h>
 #include <memory/paging.h>
 }
 
@@ -39,13 +42,59 @@ namespace lava
 {
 
     void kernel_heap::initialize_kernel_heap()
-    {
+    { // The heap is carved out of the page frames, so frames come first.
+        frame_allocator_init();
         kheap_init();
     }
 
+    void *kernel_heap::reallocate(void *ptr, size_t size)
+    {
+        return krealloc(ptr, size);
+    }
+
+    void kernel_heap::refill_zeroed_frames()
+    {
+        frame_refill_zeroed_pool(FRAME_ZEROED_POOL_REFILL_BATCH);
+    }
+
+    void kernel_heap::print_stats()
+    {
+        kheap_stats stats;
+        kheap_get_stats(&stats);
+
+        cout << "Kernel heap: " << (int)(stats.heap_size_bytes / 1024) << " KiB, "
+             << (int)(stats.bytes_in_use / 1024) << " KiB in use, peak "
+             << (int)(stats.peak_bytes_in_use / 1024) << " KiB, largest free "
+             << (int)(stats.largest_free_bytes / 1024) << " KiB." << endl;
+        cout << "Allocations: " << (int)stats.total_allocations
+             << ", frees: " << (int)stats.total_frees
+             << ", failed: " << (int)stats.failed_allocations << "." << endl;
+        cout << "Requested " << (int)(stats.bytes_requested / 1024) << " KiB, rounded up to "
+             << (int)(stats.bytes_allocated / 1024) << " KiB." << endl;
+
+        slab_cache_stats slab;
+        for (int i = 0; kheap_get_slab_stats(i, &slab) == 0; i++)
+        {
+            cout << "Slab " << (int)slab.object_size << ": "
+                 << (int)slab.objects_in_use << "/" << (int)slab.total_objects << " objects, "
+                 << (int)slab.total_pages << " pages." << endl;
+        }
+
+        kheap_call_site site;
+        for (int i = 0; kheap_get_call_site(i, &site) == 0; i++)
+        {
+            cout << "Call site " << (int)(uint32_t)site.caller << ": "
+                 << (int)site.total_allocations << " allocations, "
+                 << (int)site.bytes_requested << " bytes." << endl;
+        }
+    }
+
     void vm::initialize()
     { // Make 4GB virtual memory address space for the kernel and switch to it.
-        _kvm = make_new_4GB_virtual_memory_address_space(PAGING_IS_WRITEABLE | PAGING_IS_PRESENT | PAGING_ACCESS_FROM_ALL);
+      // Its page tables are shared with every task, so they stay kernel only.
+        paging_initialize_large_pages();
+        paging_initialize_global_pages();
+        _kvm = make_new_4GB_virtual_memory_address_space(PAGING_IS_WRITEABLE | PAGING_IS_PRESENT);
         paging_install_kernel_page(_kvm);
         switch_to_kvm();
         enable_paging();
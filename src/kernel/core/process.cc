@@ -1,6 +1,5 @@
 #include <process.hh>
 #include <iostream.hh>
-#include <memory.hh>
 #include <panic.hh>
 
 extern "C"
@@ -48,15 +47,14 @@ namespace lava
         tss_load(0x28);
     }
 
-    void proc::load_user_page()
+    void proc::load_user_segments()
     {
-        load_user_task_page();
+        load_user_data_segment_registers();
     }
 
-    void proc::load_kernel_page()
+    void proc::load_kernel_segments()
     {
         load_kernel_data_segment_registers();
-        vm::get_instance().switch_to_kvm();
     }
 
     void proc::save_current_task_state(struct interrupt_frame *frame)
@@ -76,6 +76,35 @@ namespace lava
         return *this;
     }
 
+    string &string::operator+=(const char *val)
+    { // Grow the buffer with the heap, most appends do not have to copy it.
+        if (val == nullptr)
+        {
+            return *this;
+        }
+
+        size_t length = (_str != nullptr) ? strlen(_str) : 0;
+        char *str = static_cast<char *>(kernel_heap::reallocate(_str, length + strlen(val) + 1));
+        if (str != nullptr)
+        {
+            strcpy(str + length, val);
+            _str = str;
+        }
+
+        return *this;
+    }
+
+    string &string::operator+=(const string &val)
+    {
+        if (&val == this)
+        { // The buffer may move while we read from it.
+            string copy(val);
+            return *this += copy._str;
+        }
+
+        return *this += val._str;
+    }
+
     const char *string::data() const
     {
         return _str;
@@ -7,23 +7,33 @@
 extern "C"
 {
 #include <interrupt.h>
+#include <errno.h>
+#include <memory/paging.h>
+#include <task/task.h>
 
     void *syscall_handler(int num, interrupt_frame *frame)
     { // System callback function.
 
         void *res = NULL;
-        lava::proc::get_instance().load_kernel_page();
+        // The kernel is mapped in every task directory, so the syscall runs
+        // on the directory of the task and only the data segments change.
+        lava::proc::get_instance().load_kernel_segments();
 
         // Save state of the task, we can resume from that state at any time that we like.
         // We can pause tasks, do some thing else and then resume them later on.
         lava::proc::get_instance().save_current_task_state(frame);
 
         lava::sys_args args;
-        args.load_args(frame);
-        res = lava::syscalls::get_instance().call(num, args);
+        if (args.load_args(frame) < 0)
+        { // The stack pointer of the task does not point at its own memory.
+            res = (void *)-1;
+        }
+        else
+        {
+            res = lava::syscalls::get_instance().call(num, args);
+        }
 
-        // Switch back to task page and return response.
-        lava::proc::get_instance().load_user_page();
+        lava::proc::get_instance().load_user_segments();
         return res;
     }
 }
@@ -34,6 +44,14 @@ namespace lava
     {
         // Add some syscall handler function here.
         this->add(syscall_entry::SYS_zero, &sys_zero);
+        this->add(syscall_entry::SYS_fork, &sys_fork);
+        this->add(syscall_entry::SYS_close, &sys_close);
+        this->add(syscall_entry::SYS_open, &sys_open);
+        this->add(syscall_entry::SYS_brk, &sys_brk);
+        this->add(syscall_entry::SYS_sbrk, &sys_sbrk);
+        this->add(syscall_entry::SYS_mmap, &sys_mmap);
+        this->add(syscall_entry::SYS_munmap, &sys_munmap);
+        this->add(syscall_entry::SYS_heap_stats, &sys_heap_stats);
     }
 
     syscalls &syscalls::get_instance()
@@ -86,7 +104,7 @@ namespace lava
         _ret_reg[4] = ret4;
     }
 
-    uint32_t sys_args::get_arg(uint32_t n)
+    uint32_t sys_args::get_arg(uint32_t n) const
     {
         if (n < MAXIMUM_NUMBER_OF_SYSCALL_ARGS)
         {
@@ -98,16 +116,35 @@ namespace lava
         }
     }
 
-    void sys_args::load_args(interrupt_frame *frame)
-    {
-
-        uint32_t *sp_ptr = (uint32_t *)frame->esp;
+    int sys_args::load_args(interrupt_frame *frame)
+    { // The arguments are on top of the user stack, which is only an
+      // address the task gave us, so it is read as user memory. Words past
+      // the end of the user window read as 0, a call can be made with the
+      // stack pointer at the very top.
+        uint32_t args[MAXIMUM_NUMBER_OF_SYSCALL_ARGS] = {0};
+        struct task *task = get_current_task();
+        size_t size = sizeof(args);
+        if (task == NULL)
+        {
+            return -EFAULT;
+        }
 
-        proc::get_instance().load_user_page();
+        if (frame->esp <= USER_SPACE_END && USER_SPACE_END - frame->esp < size)
+        {
+            size = USER_SPACE_END - frame->esp;
+        }
 
-        __set_param(sp_ptr[0], sp_ptr[1], sp_ptr[2], sp_ptr[3], sp_ptr[4]);
+        if (size > 0)
+        {
+            int res = copy_from_user(task, (void *)frame->esp, args, size);
+            if (res < 0)
+            {
+                return res;
+            }
+        }
 
-        proc::get_instance().load_kernel_page();
+        __set_param(args[0], args[1], args[2], args[3], args[4]);
+        return 0;
     }
 
 }
\ No newline at end of file
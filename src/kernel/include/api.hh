@@ -4,4 +4,28 @@
 namespace lava
 {
     void *sys_zero(const sys_args &);
+
+    /* Copy the calling process, return the child pid to the parent. */
+    void *sys_fork(const sys_args &);
+
+    /* Open a file for the process, the arguments are the path and the fopen mode. */
+    void *sys_open(const sys_args &args);
+
+    /* Close a descriptor returned by sys_open. */
+    void *sys_close(const sys_args &args);
+
+    /* Move the end of the heap, return the end of the heap. */
+    void *sys_brk(const sys_args &args);
+
+    /* Grow or shrink the heap, return the previous end of the heap. */
+    void *sys_sbrk(const sys_args &args);
+
+    /* Map a file or anonymous memory, the only argument points to the mmap arguments. */
+    void *sys_mmap(const sys_args &args);
+
+    /* Unmap the pages of a range, they do not have to be one mapping. */
+    void *sys_munmap(const sys_args &args);
+
+    /* Dump the kernel heap stats to the console, return the bytes in use. */
+    void *sys_heap_stats(const sys_args &);
 }
\ No newline at end of file
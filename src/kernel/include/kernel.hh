@@ -11,4 +11,5 @@
 extern "C"
 {
     void kernel_main();
+    void kernel_idle();
 }
\ No newline at end of file
@@ -17,6 +17,15 @@ namespace lava
     {
     public:
         static void initialize_kernel_heap();
+
+        // Grow or shrink a buffer from `new`, in place when the heap can.
+        static void *reallocate(void *ptr, size_t size);
+
+        // Dump the heap usage, fragmentation and slab caches to the console.
+        static void print_stats();
+
+        // Clear some free page frames ahead of time, called when idle.
+        static void refill_zeroed_frames();
     };
 
     class vm : public arch_interface
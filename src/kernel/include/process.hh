@@ -24,8 +24,8 @@ namespace lava
         void operator=(proc const &) = delete;
         void operator=(proc &&) = delete;
 
-        void load_user_page();
-        void load_kernel_page();
+        void load_user_segments();
+        void load_kernel_segments();
         void load_proc(const string &filename);
         void save_current_task_state(struct interrupt_frame *frame);
         void save_the_syscall_arguments(struct interrupt_frame *frame);
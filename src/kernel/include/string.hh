@@ -22,6 +22,9 @@ namespace lava
         friend ostream &operator<<(ostream &os, const string &str);
         string &operator=(const char *str);
 
+        string &operator+=(const char *str);
+        string &operator+=(const string &str);
+
     private:
         char *_str;
     };
@@ -14,8 +14,8 @@ namespace lava
         sys_args() = default;
         ~sys_args() = default;
 
-        uint32_t get_arg(uint32_t n); /* Get a syscall argument. */
-        void load_args(interrupt_frame *frame);
+        uint32_t get_arg(uint32_t n) const; /* Get a syscall argument. */
+        int load_args(interrupt_frame *frame); /* 0, or -EFAULT for a bad user stack. */
 
     private:
         void __set_param(uint32_t ret,
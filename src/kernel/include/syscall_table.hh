@@ -12,7 +12,12 @@ namespace lava
         SYS_read = 3,
         SYS_write = 4,
         SYS_close = 6,
-        SYS_open = 45
+        SYS_brk = 12,
+        SYS_sbrk = 13,
+        SYS_open = 45,
+        SYS_mmap = 90,
+        SYS_munmap = 91,
+        SYS_heap_stats = 99
     };
 
 }
\ No newline at end of file
@@ -15,9 +15,15 @@
 #define ENOENT 2
 #define ESRCH 3
 #define EIO 5
+#define EBADF 9
 #define ENOMEM 12
+#define EFAULT 14
+#define EEXIST 17
+#define ENODEV 19
 #define EINVAL 22
+#define EMFILE 24
 #define EROFS 30
+#define ETIMEDOUT 110
 
 #define IS_ERR_VALUE(x) (unsigned long)(void *)(x) >= (unsigned long)-MAX_ERRNO
 
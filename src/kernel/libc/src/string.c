@@ -2,11 +2,29 @@
 
 void *memset(void *ptr, int c, size_t size)
 {
-    char *c_ptr = (char *)ptr;
-    for (int i = 0; i < size; i++)
+    unsigned char *c_ptr = (unsigned char *)ptr;
+
+    // Byte by byte up to a word boundary, then a whole word at a time.
+    while (size > 0 && ((uint32_t)c_ptr % sizeof(uint32_t)))
+    {
+        *c_ptr++ = (unsigned char)c;
+        size--;
+    }
+
+    uint32_t word = (unsigned char)c * 0x01010101U;
+    uint32_t *w_ptr = (uint32_t *)c_ptr;
+    for (; size >= sizeof(uint32_t); size -= sizeof(uint32_t))
     {
-        c_ptr[i] = (char)c;
+        *w_ptr++ = word;
     }
+
+    c_ptr = (unsigned char *)w_ptr;
+    while (size > 0)
+    {
+        *c_ptr++ = (unsigned char)c;
+        size--;
+    }
+
     return ptr;
 }
 
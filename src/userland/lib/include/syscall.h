@@ -0,0 +1,14 @@
+#pragma once
+#include <stdint.h>
+
+// Syscall numbers of the kernel, see `syscall_table.hh`.
+#define SYS_fork 2
+#define SYS_close 6
+#define SYS_brk 12
+#define SYS_sbrk 13
+#define SYS_open 45
+#define SYS_mmap 90
+#define SYS_munmap 91
+
+// Raise the syscall `num`, the arguments are passed on the stack.
+uint32_t _syscall(uint32_t num, uint32_t arg0, uint32_t arg1, uint32_t arg2, uint32_t arg3, uint32_t arg4);
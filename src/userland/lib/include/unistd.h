@@ -0,0 +1,15 @@
+#pragma once
+#include <stdint.h>
+
+// Set the end of the heap, 0 on success.
+int brk(void *address);
+
+// Move the end of the heap by `increment`, return the previous end,
+// or (void *)-1 if the heap can not move.
+void *sbrk(intptr_t increment);
+
+// Open a file, `mode` is an fopen mode like "r". Return a descriptor,
+// or -1 if the file can not be opened.
+int open(const char *path, const char *mode);
+
+int close(int fd);
@@ -0,0 +1,175 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+// Small blocks come in power of two size classes, from 16 to 2048 bytes
+// with the header. Each class keeps a free list, and is refilled a page at
+// a time from the heap (sbrk), so most calls never enter the kernel.
+// Larger blocks get pages of their own from mmap and are unmapped on free.
+#define MALLOC_MIN_CLASS_SHIFT  4
+#define MALLOC_TOTAL_CLASSES    8
+#define MALLOC_MAX_CLASS_SIZE   (1 << (MALLOC_MIN_CLASS_SHIFT + MALLOC_TOTAL_CLASSES - 1))
+#define MALLOC_PAGE_SIZE        4096
+#define MALLOC_LARGE            0xFF
+
+struct malloc_header
+{ // Right in front of every block, keeps the block 8 bytes aligned.
+    uint32_t size;  // Bytes of the block, the header included.
+    uint32_t class; // Size class, or `MALLOC_LARGE` for a mapped block.
+};
+
+struct malloc_free_block
+{
+    struct malloc_header header;
+    struct malloc_free_block *next;
+};
+
+static struct malloc_free_block *malloc_free_lists[MALLOC_TOTAL_CLASSES];
+
+static int malloc_get_class(size_t size)
+{ // Smallest class which blocks hold `size` bytes and the header.
+    int class = 0;
+    while ((1U << (MALLOC_MIN_CLASS_SHIFT + class)) < size + sizeof(struct malloc_header))
+    {
+        class++;
+    }
+
+    return class;
+}
+
+static int malloc_refill(int class)
+{ // Cut a fresh page of the heap into blocks of the class.
+    uint32_t block_size = 1U << (MALLOC_MIN_CLASS_SHIFT + class);
+    char *page = sbrk(MALLOC_PAGE_SIZE);
+    if (page == (void *)-1)
+    {
+        return -1;
+    }
+
+    for (uint32_t offset = 0; offset + block_size <= MALLOC_PAGE_SIZE; offset += block_size)
+    {
+        struct malloc_free_block *block = (struct malloc_free_block *)(page + offset);
+        block->header.size = block_size;
+        block->header.class = class;
+        block->next = malloc_free_lists[class];
+        malloc_free_lists[class] = block;
+    }
+
+    return 0;
+}
+
+static void *malloc_large(size_t size)
+{
+    size_t total = (size + sizeof(struct malloc_header) + MALLOC_PAGE_SIZE - 1) & ~(MALLOC_PAGE_SIZE - 1);
+    if (total < size)
+    {
+        return NULL;
+    }
+
+    struct malloc_header *header = mmap(NULL, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (header == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    header->size = total;
+    header->class = MALLOC_LARGE;
+    return header + 1;
+}
+
+void *malloc(size_t size)
+{
+    if (size == 0)
+    {
+        return NULL;
+    }
+
+    if (size > MALLOC_MAX_CLASS_SIZE - sizeof(struct malloc_header))
+    {
+        return malloc_large(size);
+    }
+
+    int class = malloc_get_class(size);
+    if (malloc_free_lists[class] == NULL && malloc_refill(class) < 0)
+    {
+        return NULL;
+    }
+
+    struct malloc_free_block *block = malloc_free_lists[class];
+    malloc_free_lists[class] = block->next;
+    return &block->header + 1;
+}
+
+void free(void *ptr)
+{
+    if (ptr == NULL)
+    {
+        return;
+    }
+
+    struct malloc_header *header = (struct malloc_header *)ptr - 1;
+    if (header->class == MALLOC_LARGE)
+    {
+        munmap(header, header->size);
+        return;
+    }
+
+    struct malloc_free_block *block = (struct malloc_free_block *)header;
+    block->next = malloc_free_lists[header->class];
+    malloc_free_lists[header->class] = block;
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+    size_t total = nmemb * size;
+    if (size != 0 && total / size != nmemb)
+    {
+        return NULL;
+    }
+
+    // Reused blocks hold old data, fresh pages are zeroed already but
+    // there is no telling them apart here.
+    char *ptr = malloc(total);
+    for (size_t i = 0; ptr != NULL && i < total; i++)
+    {
+        ptr[i] = 0;
+    }
+
+    return ptr;
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    if (ptr == NULL)
+    {
+        return malloc(size);
+    }
+
+    if (size == 0)
+    {
+        free(ptr);
+        return NULL;
+    }
+
+    struct malloc_header *header = (struct malloc_header *)ptr - 1;
+    size_t capacity = header->size - sizeof(struct malloc_header);
+    if (size <= capacity)
+    { // Still fits, the block is kept as it is.
+        return ptr;
+    }
+
+    char *new_ptr = malloc(size);
+    if (new_ptr == NULL)
+    {
+        return NULL;
+    }
+
+    for (size_t i = 0; i < capacity; i++)
+    {
+        new_ptr[i] = ((char *)ptr)[i];
+    }
+
+    free(ptr);
+    return new_ptr;
+}
@@ -0,0 +1,30 @@
+#include <sys/mman.h>
+#include <syscall.h>
+
+struct mmap_args
+{ // The kernel takes more arguments than fit in a syscall, they go by pointer.
+    uint32_t address;
+    uint32_t length;
+    uint32_t prot;
+    uint32_t flags;
+    int fd;
+    uint32_t offset;
+};
+
+void *mmap(void *address, size_t length, int prot, int flags, int fd, uint32_t offset)
+{
+    struct mmap_args args = {
+        .address = (uint32_t)address,
+        .length = length,
+        .prot = prot,
+        .flags = flags,
+        .fd = fd,
+        .offset = offset};
+
+    return (void *)_syscall(SYS_mmap, (uint32_t)&args, 0, 0, 0, 0);
+}
+
+int munmap(void *address, size_t length)
+{
+    return (int)_syscall(SYS_munmap, (uint32_t)address, length, 0, 0, 0);
+}
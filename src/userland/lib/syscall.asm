@@ -0,0 +1,21 @@
+[BITS 32]
+section .text
+global _syscall
+
+; C prototype: uint32_t _syscall(uint32_t num, uint32_t arg0, ..., uint32_t arg4);
+; The kernel reads the arguments from the user stack, the first one on top.
+_syscall:
+    push ebp
+    mov ebp, esp
+
+    push dword [ebp + 28]
+    push dword [ebp + 24]
+    push dword [ebp + 20]
+    push dword [ebp + 16]
+    push dword [ebp + 12]
+    mov eax, [ebp + 8]  ; Syscall number.
+    int 0x80
+    add esp, 20
+
+    pop ebp
+    ret
@@ -0,0 +1,23 @@
+#include <unistd.h>
+#include <syscall.h>
+
+int brk(void *address)
+{ // The kernel returns the end of the heap, which only moved on success.
+    void *end = (void *)_syscall(SYS_brk, (uint32_t)address, 0, 0, 0, 0);
+    return (end == address) ? 0 : -1;
+}
+
+void *sbrk(intptr_t increment)
+{
+    return (void *)_syscall(SYS_sbrk, (uint32_t)increment, 0, 0, 0, 0);
+}
+
+int open(const char *path, const char *mode)
+{
+    return (int)_syscall(SYS_open, (uint32_t)path, (uint32_t)mode, 0, 0, 0);
+}
+
+int close(int fd)
+{
+    return (int)_syscall(SYS_close, (uint32_t)fd, 0, 0, 0, 0);
+}